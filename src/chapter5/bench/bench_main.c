@@ -0,0 +1,246 @@
+#include <stdio.h>
+#include <stdint.h>
+#include "irq.h"
+#include "nvic.h"
+#include "sysctl.h"
+#include "systick.h"
+#include "cycle_counter.h"
+#include "uart_drv.h"
+#include "serial_print.h"
+#include "gptm.h"
+#include "task_scheduler.h"
+#include "task_flags.h"
+
+/* The benchmark image (make bench) - in place of init.c, it times the hot
+ * paths of the kernel and the drivers and prints a line of results for each:
+ *
+ * bench name=<benchmark> unit=<unit> n=<samples> min=<> avg=<> max=<>
+ *
+ * Run under QEMU with -icount, the instruction count is the clock - so the
+ * numbers are the same from run to run and only change with the code.
+ * The image exits QEMU through semihosting once done.
+ */
+
+#ifndef BENCH_REV
+#define BENCH_REV               "unknown"
+#endif
+
+#define BENCH_ROUNDS            (64u)
+#define BENCH_SERIAL_LINES      (16u)
+#define BENCH_LATENCY_US        (500u)
+
+#define BENCH_PING              (0x1u)
+#define BENCH_PONG              (0x1u)
+#define BENCH_KICK              (0x1u)
+
+// semihosting SYS_EXIT and it's reason for a normal exit
+#define SEMIHOSTING_SYS_EXIT    0x18u
+#define ADP_STOPPED_APP_EXIT    0x00020026u
+
+/* The samples of a benchmark - in whatever unit it is measured */
+typedef struct{
+    uint32_t            count;
+    uint32_t            min;
+    uint32_t            max;
+    uint32_t            total;
+}bench_samples;
+
+static bench_samples dispatch_samples;
+static bench_samples latency_samples;
+
+static task_desc* bench_ping;
+static task_desc* bench_pong;
+static task_desc* bench_latency;
+
+static volatile uint32_t ping_cycles;
+static volatile uint32_t callback_cycles;
+
+static void bench_sample(bench_samples* samples, uint32_t value)
+{
+    if(samples->count == 0 || value < samples->min)
+    {
+        samples->min = value;
+    }
+
+    if(value > samples->max)
+    {
+        samples->max = value;
+    }
+
+    samples->total += value;
+    samples->count++;
+}
+
+static void bench_print(const char* name, const char* unit, const bench_samples* samples)
+{
+    serial_puts("bench name=");
+    serial_puts(name);
+    serial_puts(" unit=");
+    serial_puts(unit);
+    serial_puts(" n=");
+    serial_put_uint(samples->count);
+    serial_puts(" min=");
+    serial_put_uint(samples->min);
+    serial_puts(" avg=");
+    serial_put_uint(samples->count ? samples->total / samples->count : 0);
+    serial_puts(" max=");
+    serial_put_uint(samples->max);
+    serial_putchar('\n');
+}
+
+/* A benchmark measured the once */
+static void bench_print_one(const char* name, const char* unit, uint32_t value)
+{
+    bench_samples samples = {0};
+
+    bench_sample(&samples, value);
+    bench_print(name, unit, &samples);
+}
+
+/* Tell QEMU to exit - through the semihosting SYS_EXIT call.
+ * Refer: ARM Semihosting Specification, SYS_EXIT (0x18)
+ */
+static void bench_exit(void)
+{
+    register uint32_t op __asm__ ("r0") = SEMIHOSTING_SYS_EXIT;
+    register uint32_t reason __asm__ ("r1") = ADP_STOPPED_APP_EXIT;
+
+    __asm__ __volatile__ ("bkpt 0xAB" : : "r" (op), "r" (reason) : "memory");
+
+    while(1);
+}
+
+/* The timer callback of the latency benchmark - release the task it is
+ * timed to. The cycle counter is read first thing in the callback, after
+ * the interrupt entry and the GPTM handler's own work.
+ */
+static void bench_timer_callback(gptm_id id, void* arg)
+{
+    (void)id;
+    (void)arg;
+
+    callback_cycles = cycle_counter_get();
+    task_flags_set(bench_latency, BENCH_KICK);
+}
+
+/* Dispatch - ping and pong are released by each other at the same priority,
+ * so one only runs once the other is done: the time from ping's last word
+ * to pong's first is the scheduler's dispatch of a task that returns to
+ * the next one ready.
+ */
+static void bench_ping_task(void)
+{
+    task_flags_take(BENCH_PING);
+    task_flags_set(bench_pong, BENCH_PONG);
+    ping_cycles = cycle_counter_get();
+}
+
+static void bench_pong_task(void)
+{
+    uint32_t now = cycle_counter_get();
+
+    task_flags_take(BENCH_PONG);
+    bench_sample(&dispatch_samples, now - ping_cycles);
+
+    if(dispatch_samples.count < BENCH_ROUNDS)
+    {
+        task_flags_set(bench_ping, BENCH_PING);
+    }
+    else
+    {
+        bench_print("dispatch", "cycles", &dispatch_samples);
+        gptm_start_one_shot(GPTM_TIMER0, BENCH_LATENCY_US, &bench_timer_callback, NULL);
+    }
+}
+
+/* Callback to task latency - from the timer interrupt's callback to the
+ * task it releases running, with the CPU idle meanwhile. The interrupt
+ * entry and the GPTM handler ahead of the callback aren't counted. Once done, print the
+ * results and exit - "bench done" tells the host the run is complete.
+ */
+static void bench_latency_task(void)
+{
+    uint32_t now = cycle_counter_get();
+
+    task_flags_take(BENCH_KICK);
+    bench_sample(&latency_samples, now - callback_cycles);
+
+    if(latency_samples.count < BENCH_ROUNDS)
+    {
+        gptm_start_one_shot(GPTM_TIMER0, BENCH_LATENCY_US, &bench_timer_callback, NULL);
+        return;
+    }
+
+    bench_print("callback_to_task", "cycles", &latency_samples);
+    serial_puts("bench done\n");
+
+    bench_exit();
+}
+
+static void bench_add_task(task_start_fptr start, uint32_t trigger, task_desc** handle)
+{
+    task_attr attr = {0};
+
+    attr.start = start;
+    attr.priority = TASK_PRIO_DEFAULT;
+    attr.trigger = trigger;
+    task_scheduler_add_task_attr(&attr, handle);
+}
+
+int main(void)
+{
+    const char *line = "...............................................................\n";
+    uint32_t startup_counts, setclk_counts;
+    uint32_t start, serial_cycles;
+    uint32_t idx;
+
+    /* The SysTick has been counting down since reset (see startup_lm3s6965.c)
+     * - so how far it got is the startup time, at the clock out of reset.
+     */
+    startup_counts = STRELOAD_MASK - systick_get_current();
+
+    /* sysctl_setclk() - timed with the SysTick still counting at the clock
+     * being switched from. The same configuration as in init.c.
+     */
+    start = systick_get_current();
+    sysctl_setclk(SYSCTL_PLL_SYSCLK | SYSCTL_RCC_USESYSDIV | SYSCTL_RCC_SYSDIV_11 |
+                  SYSCTL_RCC_XTAL_8MHZ | SYSCTL_RCC_OSCSRC_MOSC | SYSCTL_RCC_IOSCDIS, 0);
+    setclk_counts = (start - systick_get_current()) & STCURRENT_MASK;
+
+    irq_master_enable();
+
+    systick_set_period_ms(1u);
+    systick_irq_enable();
+    systick_enable();
+    cycle_counter_init();
+
+    uart_init(UART_BAUD_115200);
+    gptm_init(GPTM_TIMER0);
+
+    /* serial_puts() - the cycles to send the lines, filler the host filters out */
+    start = cycle_counter_get();
+    for(idx = 0; idx < BENCH_SERIAL_LINES; idx++)
+    {
+        serial_puts(line);
+    }
+    serial_cycles = cycle_counter_get() - start;
+
+    serial_puts("bench rev=" BENCH_REV "\n");
+    bench_print_one("startup", "systick", startup_counts);
+    bench_print_one("sysctl_setclk", "systick", setclk_counts);
+    bench_print_one("serial_puts_64b", "cycles", serial_cycles / BENCH_SERIAL_LINES);
+
+    bench_add_task(&bench_ping_task, BENCH_PING, &bench_ping);
+    bench_add_task(&bench_pong_task, BENCH_PONG, &bench_pong);
+    bench_add_task(&bench_latency_task, BENCH_KICK, &bench_latency);
+    task_flags_set(bench_ping, BENCH_PING);
+
+    if(task_scheduler_run_preemptive() != SCHEDULER_OKAY)
+    {
+        serial_puts("bench error=stacks\n");
+    }
+
+    bench_exit();
+
+    return 0;
+}
@@ -0,0 +1,159 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include "lm3s6965_memmap.h"
+#include "work_queue.h"
+#include "context_switch.h"
+#include "trace.h"
+
+#define SCB_BASE        ((M3_PERIPHERAL_BASE)+ 0x00000D00u)
+#define PENDSV_EXCEPTION 14u
+
+/* Number of registers stacked by the hardware on exception entry
+ * (R0-R3, R12, LR, PC and xPSR) and by the PendSV handler (R4-R11)
+ */
+#define HW_FRAME_WORDS  8u
+#define SW_FRAME_WORDS  8u
+
+/* System Control Block register map structure.
+ * Refer: http://www.ti.com/lit/ds/symlink/lm3s6965.pdf Table 3-8
+ * Note: all offsets in comments are from SCB_BASE == 0xE000ED00
+ */
+typedef struct __attribute__ ((packed)){
+    const uint32_t CPUID;           // 0x00 CPU ID Base
+    uint32_t INTCTRL;               // 0x04 Interrupt Control and State
+    uint32_t VTABLE;                // 0x08 Vector Table Offset
+    uint32_t APINT;                 // 0x0C Application Interrupt and Reset Control
+    uint32_t SYSCTRL;               // 0x10 System Control
+    uint32_t CFGCTRL;               // 0x14 Configuration and Control
+    uint32_t SYSPRI1;               // 0x18 System Handler Priority 1
+    uint32_t SYSPRI2;               // 0x1C System Handler Priority 2
+    uint32_t SYSPRI3;               // 0x20 System Handler Priority 3
+    uint32_t SYSHNDCTRL;            // 0x24 System Handler Control and State
+}scb_regs;
+
+static volatile scb_regs *scb = (scb_regs*)SCB_BASE;
+
+/* PendSV is shared by the context switch and the deferred work queue -
+ * this tells the handler whether it's been asked to switch as well.
+ */
+static volatile bool switch_pending;
+
+/* A task's entry function is never supposed to return - its stacked LR
+ * points here so that if it ever does, we can catch it in the debugger.
+ */
+static void context_switch_task_exit(void)
+{
+    while(1);
+}
+
+/* Set PendSV to the lowest exception priority so that the context
+ * switch and deferred work are tail-chained after all other handlers.
+ */
+void context_switch_init(void)
+{
+    scb->SYSPRI3 = (scb->SYSPRI3 & ~(SYSPRI3_PENDSV_MASK)) | SYSPRI3_PENDSV_LOWEST;
+}
+
+/* Request a context switch by pending the PendSV exception.
+ * Safe to call from both thread and handler mode.
+ */
+void context_switch_request(void)
+{
+    switch_pending = true;
+    scb->INTCTRL = INTCTRL_PENDSV;
+}
+
+/* Pend the PendSV exception without asking for a context switch -
+ * to have the deferred work run.
+ */
+void context_switch_pend(void)
+{
+    scb->INTCTRL = INTCTRL_PENDSV;
+}
+
+/* The C half of the PendSV handler - runs the deferred work first (which
+ * may well ready a task), then returns whether to switch context. A switch
+ * is only ever requested with the preemptive scheduler running, so in the
+ * cooperative mode the process stack is left alone.
+ */
+uint32_t context_switch_pendsv(void)
+{
+    trace_record(TRACE_ISR_ENTER, PENDSV_EXCEPTION, 0);
+    work_queue_run();
+    trace_record(TRACE_ISR_EXIT, PENDSV_EXCEPTION, 0);
+
+    if(!switch_pending) {
+        return 0;
+    }
+
+    switch_pending = false;
+    return 1;
+}
+
+/* Build the initial stack frame of a task, so that the first time
+ * the PendSV handler switches to it, the exception return "resumes"
+ * the task at entry(arg).
+ * Returns the process stack pointer to be saved in the task descriptor.
+ */
+uint32_t* context_switch_stack_init(uint32_t* stack_top, context_entry_fptr entry, void* arg)
+{
+    uint32_t* sp = stack_top;
+    uint8_t idx;
+
+    // hardware stacked frame: xPSR, PC, LR, R12, R3, R2, R1, R0
+    *(--sp) = INITIAL_XPSR;
+    *(--sp) = (uint32_t)entry & START_ADDRESS_MASK;
+    *(--sp) = (uint32_t)&context_switch_task_exit;
+    for(idx = 0; idx < (HW_FRAME_WORDS - 4u); idx++) {
+        *(--sp) = 0;
+    }
+    *(--sp) = (uint32_t)arg;
+
+    // software stacked frame: R11-R4
+    for(idx = 0; idx < SW_FRAME_WORDS; idx++) {
+        *(--sp) = 0;
+    }
+
+    return sp;
+}
+
+/* Switch thread mode over to the process stack and continue executing
+ * in the idle function. The main stack is from here on used only by
+ * exception handlers. This function never returns.
+ */
+void __attribute__((naked)) context_switch_start(uint32_t* psp, void (*idle)(void))
+{
+    __asm__ __volatile__ (
+        "msr psp, r0            \n"
+        "movs r0, #2            \n"     // CONTROL_SPSEL_PSP
+        "msr control, r0        \n"
+        "isb                    \n"
+        "bx r1                  \n"
+    );
+}
+
+/* The context switch itself - after the deferred work has been run, and
+ * only if a switch was requested. The hardware has already stacked R0-R3,
+ * R12, LR, PC and xPSR on the process stack of the outgoing task - we stack
+ * the rest (R4-R11), let the scheduler pick the next task and unstack its
+ * R4-R11 before the exception return unstacks the remaining frame.
+ * Refer: http://www.ti.com/lit/ds/symlink/lm3s6965.pdf Section 2.5.7
+ */
+void __attribute__((naked)) _PendSV_Handler(void)
+{
+    __asm__ __volatile__ (
+        "push {r3, lr}                  \n"     // r3 keeps the MSP 8-byte aligned
+        "bl context_switch_pendsv       \n"
+        "pop {r3, lr}                   \n"
+        "cbz r0, 1f                     \n"
+        "mrs r0, psp                    \n"
+        "stmdb r0!, {r4-r11}            \n"
+        "push {r3, lr}                  \n"
+        "bl task_scheduler_switch       \n"
+        "pop {r3, lr}                   \n"
+        "ldmia r0!, {r4-r11}            \n"
+        "msr psp, r0                    \n"
+        "1:                             \n"
+        "bx lr                          \n"
+    );
+}
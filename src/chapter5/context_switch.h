@@ -0,0 +1,39 @@
+#ifndef __CONTEXT_SWITCH_H__
+#define __CONTEXT_SWITCH_H__
+
+#include <stdint.h>
+
+/* Interrupt Control and State register bits
+ * Refer: http://www.ti.com/lit/ds/symlink/lm3s6965.pdf Section 3.4 (INTCTRL)
+ */
+#define INTCTRL_PENDSV          0x10000000u
+#define INTCTRL_UNPENDSV        0x08000000u
+
+/* PendSV priority field in SYSPRI3 - set to the lowest priority (7)
+ * so a context switch only ever happens when no other handler is active.
+ */
+#define SYSPRI3_PENDSV_MASK     0x00E00000u
+#define SYSPRI3_PENDSV_LOWEST   0x00E00000u
+
+/* Initial xPSR of a task - only the Thumb bit set */
+#define INITIAL_XPSR            0x01000000u
+
+/* Mask for the stacked PC of an initial frame - a Thumb function
+ * pointer has bit 0 set, which is UNPREDICTABLE on exception return.
+ * The Thumb state comes from the stacked xPSR instead.
+ */
+#define START_ADDRESS_MASK      0xFFFFFFFEu
+
+/* CONTROL register value for thread mode running on the PSP */
+#define CONTROL_SPSEL_PSP       0x00000002u
+
+typedef void (*context_entry_fptr)(void* arg);
+
+void context_switch_init(void);
+void context_switch_request(void);
+void context_switch_pend(void);
+uint32_t context_switch_pendsv(void);
+uint32_t* context_switch_stack_init(uint32_t* stack_top, context_entry_fptr entry, void* arg);
+void context_switch_start(uint32_t* psp, void (*idle)(void));
+
+#endif /* __CONTEXT_SWITCH_H__ */
@@ -0,0 +1,109 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include "lm3s6965_memmap.h"
+#include "sysctl.h"
+#include "systick.h"
+#include "system_time.h"
+#include "cycle_counter.h"
+
+#define DEMCR_ADDR      ((M3_PERIPHERAL_BASE)+ 0x00000DFCu)
+
+/* Data Watchpoint and Trace unit register map structure - only
+ * the registers up to the cycle counter are of interest to us.
+ * Refer: ARMv7-M Architecture Reference Manual Section C1.8
+ */
+typedef struct __attribute__ ((packed)){
+    uint32_t CTRL;              // 0x00 DWT Control
+    uint32_t CYCCNT;            // 0x04 DWT Current PC Sampler Cycle Count
+}dwt_regs;
+
+/* Debug Exception and Monitor Control register - TRCENA has to be set
+ * for the DWT to be accessible.
+ */
+typedef struct __attribute__ ((packed)){
+    uint32_t DEMCR;             // 0xDFC Debug Exception and Monitor Control
+}demcr_regs;
+
+static volatile dwt_regs *dwt = (dwt_regs*)DWT_BASE;
+static volatile demcr_regs *demcr = (demcr_regs*)DEMCR_ADDR;
+
+static bool use_dwt;
+
+/* Enable the DWT cycle counter if the core has one that actually counts.
+ * QEMU for one doesn't model the DWT - there the registers read as zero
+ * and we fall back on the SysTick counter.
+ */
+void cycle_counter_init(void)
+{
+    uint32_t start;
+
+    demcr->DEMCR |= DEMCR_TRCENA;
+
+    if((dwt->CTRL & DWT_CTRL_NUMCOMP_MASK) == 0 || (dwt->CTRL & DWT_CTRL_NOCYCCNT) != 0)
+    {
+        use_dwt = false;
+        return;
+    }
+
+    dwt->CYCCNT = 0;
+    dwt->CTRL |= DWT_CTRL_CYCCNTENA;
+
+    start = dwt->CYCCNT;
+    __asm__ __volatile__ ("nop\n"
+                          "nop\n"
+                          "nop\n"
+                          "nop\n");
+
+    use_dwt = (dwt->CYCCNT != start);
+}
+
+/* A cycle count built from the system time (in SysTick periods) and the
+ * SysTick counter. The time is read on either side of the counter to make
+ * sure the two belong to the same period. If we are running with the SysTick
+ * interrupt held off, the counter may have wrapped with the period not yet
+ * accounted for in the system time - hence the check for a pending interrupt.
+ */
+static uint32_t cycle_counter_systick(void)
+{
+    uint32_t period = systick_get_period();
+    systime_t ticks;
+    uint32_t current;
+
+    do
+    {
+        ticks = system_time_get();
+        current = systick_get_current();
+    }while(ticks != system_time_get());
+
+    if(systick_irq_pending() && current > (period / 2u))
+    {
+        ticks++;
+    }
+
+    return ticks * period + (period - 1u - current);
+}
+
+/* The current cycle count - wraps around at 2^32,
+ * so only differences between two counts are meaningful.
+ */
+uint32_t cycle_counter_get(void)
+{
+    if(use_dwt)
+    {
+        return dwt->CYCCNT;
+    }
+
+    return cycle_counter_systick();
+}
+
+/* The rate at which the cycle counter counts - the system clock */
+uint32_t cycle_counter_hz(void)
+{
+    return sysctl_getclk();
+}
+
+/* Whether the counts come from the DWT rather than the SysTick fallback */
+bool cycle_counter_is_dwt(void)
+{
+    return use_dwt;
+}
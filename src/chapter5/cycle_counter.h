@@ -0,0 +1,18 @@
+#ifndef __CYCLE_COUNTER_H__
+#define __CYCLE_COUNTER_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define DEMCR_TRCENA            0x01000000u
+
+#define DWT_CTRL_CYCCNTENA      0x00000001u
+#define DWT_CTRL_NOCYCCNT       0x02000000u
+#define DWT_CTRL_NUMCOMP_MASK   0xF0000000u
+
+void cycle_counter_init(void);
+uint32_t cycle_counter_get(void);
+uint32_t cycle_counter_hz(void);
+bool cycle_counter_is_dwt(void);
+
+#endif /* __CYCLE_COUNTER_H__ */
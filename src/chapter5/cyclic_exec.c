@@ -0,0 +1,60 @@
+#include <stdio.h>
+#include <stdint.h>
+#include "irq.h"
+#include "system_time.h"
+#include "cyclic_exec.h"
+
+/* The number of frames whose entries ran past the start of the next frame */
+static volatile uint32_t frame_overruns;
+
+/* Sleep until the system time reaches t - a SysTick interrupt wakes us
+ * every tick. Interrupts are disabled across the check and the sleep, so
+ * the tick that ends the wait can't slip in between the two.
+ */
+static void cyclic_exec_wait_until(systime_t t) {
+    irq_master_disable();
+
+    while(systime_before(system_time_get(), t)) {
+        irq_wait();
+        irq_master_enable();
+        irq_master_disable();
+    }
+
+    irq_master_enable();
+}
+
+/* Run the schedule - in place of task_scheduler_run(), and likewise never
+ * returns. Dispatching is a walk through the table: no priorities, queues
+ * or heaps are consulted at runtime. The frames stay on the boundaries of
+ * the timebase - a frame that overruns is counted and the next starts late,
+ * but the one after that is back on it's boundary if it can be.
+ */
+void cyclic_exec_run(const cyclic_schedule* schedule) {
+    systime_t frame_start = system_time_get();
+    const cyclic_frame* frame;
+    uint16_t idx;
+    uint16_t entry;
+
+    while(1) {
+        for(idx = 0; idx < schedule->frame_count; idx++) {
+            frame = &schedule->frames[idx];
+
+            cyclic_exec_wait_until(frame_start);
+
+            for(entry = 0; entry < frame->count; entry++) {
+                schedule->entries[frame->first + entry]();
+            }
+
+            frame_start += schedule->frame_len;
+
+            if(systime_after(system_time_get(), frame_start)) {
+                frame_overruns++;
+            }
+        }
+    }
+}
+
+/* The number of frames that have overrun so far */
+uint32_t cyclic_exec_overruns(void) {
+    return frame_overruns;
+}
@@ -0,0 +1,35 @@
+#ifndef __CYCLIC_EXEC_H__
+#define __CYCLIC_EXEC_H__
+
+#include <stdint.h>
+#include "system_time.h"
+#include "task_scheduler.h"
+
+/* A cyclic executive - the schedule is fixed before runtime as a table of
+ * minor frames, generated by tools/gen_cyclic.py from a task table (see
+ * cyclic_tasks.def). Every frame starts on a frame boundary of the SysTick
+ * timebase and runs it's entries to completion, one after the other. The
+ * table is const - so it is in flash, along with the whole schedule.
+ */
+
+/* A minor frame - it's entries in the entry table */
+typedef struct{
+    uint16_t    first;
+    uint16_t    count;
+}cyclic_frame;
+
+/* The frames of a hyperperiod, and the length of each in systime_t units */
+typedef struct{
+    systime_t               frame_len;
+    uint16_t                frame_count;
+    const cyclic_frame*     frames;
+    const task_start_fptr*  entries;
+}cyclic_schedule;
+
+/* The schedule generated from cyclic_tasks.def - cyclic_schedule.c */
+extern const cyclic_schedule cyclic_schedule_table;
+
+void cyclic_exec_run(const cyclic_schedule* schedule);
+uint32_t cyclic_exec_overruns(void);
+
+#endif /* __CYCLIC_EXEC_H__ */
@@ -0,0 +1,48 @@
+/* Generated by tools/gen_cyclic.py from cyclic_tasks.def - do not edit.
+ * hyperperiod 50, minor frame 5 (10 frames), utilization 44.0%
+ * example_cyclic_sample: period 5 wcet 1 deadline 5
+ * example_cyclic_control: period 10 wcet 2 deadline 10
+ * example_cyclic_report: period 50 wcet 2 deadline 50
+ */
+#include <stdio.h>
+#include "cyclic_exec.h"
+#include "example_tasks.h"
+
+static const task_start_fptr cyclic_entries[16] = {
+    &example_cyclic_sample,
+    &example_cyclic_control,
+    &example_cyclic_report,
+    &example_cyclic_sample,
+    &example_cyclic_sample,
+    &example_cyclic_control,
+    &example_cyclic_sample,
+    &example_cyclic_sample,
+    &example_cyclic_control,
+    &example_cyclic_sample,
+    &example_cyclic_sample,
+    &example_cyclic_control,
+    &example_cyclic_sample,
+    &example_cyclic_sample,
+    &example_cyclic_control,
+    &example_cyclic_sample,
+};
+
+static const cyclic_frame cyclic_frames[10] = {
+    {0u, 3u},          // 0: 5 of 5
+    {3u, 1u},          // 1: 1 of 5
+    {4u, 2u},          // 2: 3 of 5
+    {6u, 1u},          // 3: 1 of 5
+    {7u, 2u},          // 4: 3 of 5
+    {9u, 1u},          // 5: 1 of 5
+    {10u, 2u},         // 6: 3 of 5
+    {12u, 1u},         // 7: 1 of 5
+    {13u, 2u},         // 8: 3 of 5
+    {15u, 1u},         // 9: 1 of 5
+};
+
+const cyclic_schedule cyclic_schedule_table = {
+    5u,
+    10u,
+    cyclic_frames,
+    cyclic_entries
+};
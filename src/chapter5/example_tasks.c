@@ -3,27 +3,110 @@
 #include "system_time.h"
 #include "uart_drv.h"
 #include "serial_print.h"
+#include "task_scheduler.h"
+#include "task_coroutine.h"
+#include "cyclic_exec.h"
 
 /* Our example tasks don't do much other than:
  * make note of the entry time in terms of systime_t and print this on the console
- * loop until the task has run for 1000 systeim_t units since it entered
+ * sleep until 1000 systeim_t units have passed since it entered - giving up the
+ * CPU to the other tasks meanwhile, rather than spinning
  * print an exit message and return.
+ * The entry time is static as it has to survive the sleep (see task_coroutine.h)
+ * The tasks share the console - each message is printed with the console
+ * mutex held, so the messages of a preempted task and the task preempting
+ * it don't get mixed up.
  */
 
+static task_mutex console_mutex = TASK_MUTEX_INIT;
+
 void example_task0(void) {
-    systime_t entry_time = system_time_get();
+    static systime_t entry_time;
+
+    TASK_BEGIN();
+
+    entry_time = system_time_get();
+    task_lock(&console_mutex);
     serial_puts("example_task0 entered system_time: ");
     serial_put_uint(entry_time);
     serial_putchar('\n');
-    while(entry_time + 1000u > system_time_get()) ;
+    task_mutex_unlock(&console_mutex);
+    task_sleep_until(entry_time + 1000u);
+    task_lock(&console_mutex);
     serial_puts("example_task0 exits!\n");
+    task_mutex_unlock(&console_mutex);
+
+    TASK_END();
 }
 
 void example_task1(void) {
-    systime_t entry_time = system_time_get();
+    static systime_t entry_time;
+
+    TASK_BEGIN();
+
+    entry_time = system_time_get();
+    task_lock(&console_mutex);
     serial_puts("example_task1 entered system_time: ");
     serial_put_uint(entry_time);
     serial_putchar('\n');
-    while(entry_time + 1000u > system_time_get());
+    task_mutex_unlock(&console_mutex);
+    task_sleep_until(entry_time + 1000u);
+    task_lock(&console_mutex);
     serial_puts("example_task1 exits!\n");
+    task_mutex_unlock(&console_mutex);
+
+    TASK_END();
+}
+
+/* A low priority task that periodically reports how much
+ * of the CPU each task has been taking, how much stack and how
+ * late it's releases have been starting - and the headroom left.
+ */
+void example_report_task(void) {
+    TASK_BEGIN();
+
+    task_lock(&console_mutex);
+    serial_puts("--- task statistics at system_time: ");
+    serial_put_uint(system_time_get());
+    serial_puts(" ---\n");
+    task_scheduler_print_stats();
+    task_scheduler_print_stacks();
+    task_scheduler_print_jitter();
+    task_scheduler_print_load();
+    task_mutex_unlock(&console_mutex);
+
+    TASK_END();
+}
+
+/* The entries of the cyclic executive's example schedule, see cyclic_tasks.def.
+ * They run to completion one after the other within their frames - so they
+ * neither wait nor need to lock the console. The sampler takes a "reading"
+ * every 5 ms, the controller filters the readings every 10 ms and the report
+ * prints where things are at every 20th time it is run - once a second.
+ */
+static uint32_t cyclic_samples;
+static uint32_t cyclic_reading;
+static uint32_t cyclic_filtered;
+
+void example_cyclic_sample(void) {
+    cyclic_reading = system_time_get();
+    cyclic_samples++;
+}
+
+void example_cyclic_control(void) {
+    cyclic_filtered = (cyclic_filtered * 3u + cyclic_reading) / 4u;
+}
+
+void example_cyclic_report(void) {
+    static uint32_t runs;
+
+    if(++runs % 20u != 0) {
+        return;
+    }
+
+    serial_puts("cyclic: samples ");
+    serial_put_uint(cyclic_samples);
+    serial_puts(" overruns ");
+    serial_put_uint(cyclic_exec_overruns());
+    serial_putchar('\n');
 }
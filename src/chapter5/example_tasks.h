@@ -1,3 +1,7 @@
 void example_task0(void);
 void example_task1(void);
+void example_report_task(void);
 
+void example_cyclic_sample(void);
+void example_cyclic_control(void);
+void example_cyclic_report(void);
@@ -0,0 +1,63 @@
+#ifndef __EXCLUSIVE_H__
+#define __EXCLUSIVE_H__
+
+#include <stdint.h>
+
+#ifdef SIM_HOST
+
+/* The host simulation build runs on one thread and takes interrupts only
+ * as they are enabled - nothing comes between a load and a store.
+ */
+static inline uint32_t exclusive_load(volatile uint32_t* addr)
+{
+    return *addr;
+}
+
+static inline uint32_t exclusive_store(volatile uint32_t* addr, uint32_t value)
+{
+    *addr = value;
+
+    return 0;
+}
+
+static inline void exclusive_clear(void)
+{
+}
+
+#else
+
+/* Load-exclusive and store-exclusive of a word. The store fails (returns
+ * non-zero) if anything else stored to it since the load - or if any
+ * exception was taken since, as exception entry and return clear the
+ * exclusive monitor. So an update interrupted by another update of the
+ * same word is simply retried - and unlike a compare-and-swap, a word
+ * changed and changed back meanwhile (ABA) doesn't go unnoticed.
+ * Refer: ARMv7-M Architecture Reference Manual Section A3.4
+ */
+static inline uint32_t exclusive_load(volatile uint32_t* addr)
+{
+    uint32_t value;
+
+    __asm__ __volatile__ ("ldrex %0, [%1]" : "=r" (value) : "r" (addr) : "memory");
+
+    return value;
+}
+
+static inline uint32_t exclusive_store(volatile uint32_t* addr, uint32_t value)
+{
+    uint32_t failed;
+
+    __asm__ __volatile__ ("strex %0, %2, [%1]" : "=&r" (failed) : "r" (addr), "r" (value) : "memory");
+
+    return failed;
+}
+
+/* Give up an exclusive load without a store */
+static inline void exclusive_clear(void)
+{
+    __asm__ __volatile__ ("clrex" ::: "memory");
+}
+
+#endif /* SIM_HOST */
+
+#endif /* __EXCLUSIVE_H__ */
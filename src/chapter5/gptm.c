@@ -0,0 +1,257 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include "lm3s6965_memmap.h"
+#include "sysctl.h"
+#include "nvic.h"
+#include "system_time.h"
+#include "trace.h"
+#include "gptm.h"
+
+#define MICROSECS_IN_SEC        1000000u
+
+/* General-Purpose Timer Module register map structure.
+ * Refer: http://www.ti.com/lit/ds/symlink/lm3s6965.pdf Table 10-4
+ * Note: all offsets in comments are from the TIMERn_BASE
+ */
+typedef struct __attribute__ ((packed)){
+    uint32_t CFG;               // 0x00 GPTM Configuration
+    uint32_t TAMR;              // 0x04 GPTM TimerA Mode
+    uint32_t TBMR;              // 0x08 GPTM TimerB Mode
+    uint32_t CTL;               // 0x0C GPTM Control
+    uint32_t reserved0[2];      // 0x10-0x14 reserved
+    uint32_t IMR;               // 0x18 GPTM Interrupt Mask
+    const uint32_t RIS;         // 0x1C GPTM Raw Interrupt Status
+    const uint32_t MIS;         // 0x20 GPTM Masked Interrupt Status
+    uint32_t ICR;               // 0x24 GPTM Interrupt Clear
+    uint32_t TAILR;             // 0x28 GPTM TimerA Interval Load
+    uint32_t TBILR;             // 0x2C GPTM TimerB Interval Load
+    uint32_t TAMATCHR;          // 0x30 GPTM TimerA Match
+    uint32_t TBMATCHR;          // 0x34 GPTM TimerB Match
+    uint32_t TAPR;              // 0x38 GPTM TimerA Prescale
+    uint32_t TBPR;              // 0x3C GPTM TimerB Prescale
+    uint32_t TAPMR;             // 0x40 GPTM TimerA Prescale Match
+    uint32_t TBPMR;             // 0x44 GPTM TimerB Prescale Match
+    const uint32_t TAR;         // 0x48 GPTM TimerA
+    const uint32_t TBR;         // 0x4C GPTM TimerB
+}gptm_regs;
+
+static const uint32_t gptm_base[GPTM_COUNT] = {
+    TIMER0_BASE,
+    TIMER1_BASE,
+    TIMER2_BASE,
+    TIMER3_BASE
+};
+
+static volatile gptm_regs* const gptm[GPTM_COUNT] = {
+    (gptm_regs*)TIMER0_BASE,
+    (gptm_regs*)TIMER1_BASE,
+    (gptm_regs*)TIMER2_BASE,
+    (gptm_regs*)TIMER3_BASE
+};
+
+/* The timer A interrupt of each module - by vector number */
+static const uint32_t gptm_irq[GPTM_COUNT] = {
+    IRQ_TIMER0A,
+    IRQ_TIMER1A,
+    IRQ_TIMER2A,
+    IRQ_TIMER3A
+};
+
+/* The callback of each timer and whether it's a one-shot still to expire */
+static gptm_callback gptm_cb[GPTM_COUNT];
+static void* gptm_cb_arg[GPTM_COUNT];
+static volatile bool gptm_armed[GPTM_COUNT];
+
+/* Microseconds as cycles of the system clock - to within a few cycles,
+ * for any clock rate (16.67 MHz isn't a whole number of MHz). We don't
+ * link against libgcc for a 64-bit division - so the seconds, milliseconds
+ * and microseconds are each scaled on their own with 32-bit divisions.
+ */
+static uint64_t gptm_scale_microsec(uint32_t microsec)
+{
+    uint32_t hz = sysctl_getclk();
+    uint32_t khz = hz / 1000u;
+    uint32_t hz_rem = hz % 1000u;
+    uint32_t secs = microsec / MICROSECS_IN_SEC;
+    uint32_t millisecs = (microsec / 1000u) % 1000u;
+    uint32_t usecs = microsec % 1000u;
+
+    return (uint64_t)secs * hz +
+           millisecs * khz + (millisecs * hz_rem) / 1000u +
+           (usecs * khz) / 1000u + (usecs * hz_rem) / MICROSECS_IN_SEC;
+}
+
+/* Utility function to convert microseconds to timer cycles at the system
+ * clock - 0 if that doesn't fit the 32-bit interval load register
+ */
+static uint32_t gptm_microsec_to_cycles(uint32_t microsec)
+{
+    uint64_t cycles = gptm_scale_microsec(microsec);
+
+    if(cycles == 0 || cycles > 0xFFFFFFFFu)
+    {
+        return 0;
+    }
+
+    return (uint32_t)cycles;
+}
+
+/* Enable the clock of a timer module, set it up as a 32-bit timer
+ * and enable it's timeout interrupt - the timer itself is left stopped.
+ */
+void gptm_init(gptm_id id)
+{
+    volatile gptm_regs* timer = gptm[id];
+
+    sysctl_periph_clk_enable(gptm_base[id]);
+
+    timer->CTL &= ~(GPTMCTL_TAEN);
+    timer->CFG = GPTMCFG_32BIT;
+    timer->ICR = GPTMICR_TATOCINT;
+    timer->IMR |= GPTMIMR_TATOIM;
+
+    gptm_armed[id] = false;
+
+    nvic_irq_enable(gptm_irq[id]);
+}
+
+/* Load the timer with an interval in cycles in the given mode and start it */
+static void gptm_start(gptm_id id, uint32_t mode, uint32_t cycles, gptm_callback callback, void* arg)
+{
+    volatile gptm_regs* timer = gptm[id];
+
+    timer->CTL &= ~(GPTMCTL_TAEN);
+    timer->ICR = GPTMICR_TATOCINT;
+
+    gptm_cb[id] = callback;
+    gptm_cb_arg[id] = arg;
+    gptm_armed[id] = true;
+
+    timer->TAMR = mode;
+    timer->TAILR = cycles - 1u;
+    timer->CTL |= GPTMCTL_TAEN;
+}
+
+/* Start a timer to call back every period_us microseconds - with the
+ * timer reloading in hardware, the period doesn't drift whatever the
+ * interrupt latency. Returns false if the period is 0 or too long.
+ */
+bool gptm_start_periodic(gptm_id id, uint32_t period_us, gptm_callback callback, void* arg)
+{
+    uint32_t cycles = gptm_microsec_to_cycles(period_us);
+
+    if(cycles == 0)
+    {
+        return false;
+    }
+
+    gptm_start(id, GPTMTAMR_PERIODIC, cycles, callback, arg);
+    return true;
+}
+
+/* Start a timer to call back once, delay_us microseconds from now.
+ * Returns false if the delay is 0 or too long.
+ */
+bool gptm_start_one_shot(gptm_id id, uint32_t delay_us, gptm_callback callback, void* arg)
+{
+    uint32_t cycles = gptm_microsec_to_cycles(delay_us);
+
+    if(cycles == 0)
+    {
+        return false;
+    }
+
+    gptm_start(id, GPTMTAMR_ONE_SHOT, cycles, callback, arg);
+    return true;
+}
+
+/* Schedule the next event of a timer at a point on the 64-bit microsecond
+ * clock (system_time_us()) - as a one-shot loaded with the time left to it,
+ * so an event further out than the 32-bit timer reaches is the caller's
+ * to re-schedule from the callback. An event already due is called back
+ * as soon as the timer interrupt can be taken.
+ */
+void gptm_schedule_at(gptm_id id, uint64_t when_us, gptm_callback callback, void* arg)
+{
+    uint64_t now = system_time_us();
+    uint64_t delay = (when_us > now) ? when_us - now : 0;
+    uint64_t cycles;
+
+    // past what the 32-bit timer reaches at any clock rate anyway
+    if(delay > 0xFFFFFFFFu)
+    {
+        delay = 0xFFFFFFFFu;
+    }
+
+    cycles = gptm_scale_microsec((uint32_t)delay);
+
+    if(cycles == 0)
+    {
+        cycles = 1u;
+    }
+    else if(cycles > 0xFFFFFFFFu)
+    {
+        cycles = 0xFFFFFFFFu;
+    }
+
+    gptm_start(id, GPTMTAMR_ONE_SHOT, (uint32_t)cycles, callback, arg);
+}
+
+/* Stop a timer - no more call backs until it is started again */
+void gptm_stop(gptm_id id)
+{
+    gptm[id]->CTL &= ~(GPTMCTL_TAEN);
+    gptm[id]->ICR = GPTMICR_TATOCINT;
+    gptm_armed[id] = false;
+}
+
+/* Whether a timer is running - periodic, or a one-shot yet to expire */
+bool gptm_running(gptm_id id)
+{
+    return gptm_armed[id];
+}
+
+/* The common interrupt handler - clear the timeout and call back. A one-shot
+ * timer has stopped by now, so it is marked as such first - the callback
+ * may then start it again.
+ */
+static void gptm_irq_handler(gptm_id id)
+{
+    volatile gptm_regs* timer = gptm[id];
+
+    trace_record(TRACE_ISR_ENTER, (uint8_t)gptm_irq[id], 0);
+
+    timer->ICR = GPTMICR_TATOCINT;
+
+    if((timer->TAMR & GPTMTAMR_MODE_MASK) == GPTMTAMR_ONE_SHOT)
+    {
+        gptm_armed[id] = false;
+    }
+
+    if(gptm_cb[id] != 0)
+    {
+        gptm_cb[id](id, gptm_cb_arg[id]);
+    }
+
+    trace_record(TRACE_ISR_EXIT, (uint8_t)gptm_irq[id], 0);
+}
+
+void gptm0_irq_handler(void)
+{
+    gptm_irq_handler(GPTM_TIMER0);
+}
+
+void gptm1_irq_handler(void)
+{
+    gptm_irq_handler(GPTM_TIMER1);
+}
+
+void gptm2_irq_handler(void)
+{
+    gptm_irq_handler(GPTM_TIMER2);
+}
+
+void gptm3_irq_handler(void)
+{
+    gptm_irq_handler(GPTM_TIMER3);
+}
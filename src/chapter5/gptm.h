@@ -0,0 +1,47 @@
+#ifndef __GPTM_H__
+#define __GPTM_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* The four general-purpose timer modules - each driven here as a single
+ * 32-bit timer (timer A), counting down at the system clock.
+ */
+typedef enum{
+    GPTM_TIMER0 = 0,
+    GPTM_TIMER1,
+    GPTM_TIMER2,
+    GPTM_TIMER3,
+    GPTM_COUNT
+}gptm_id;
+
+#define GPTMCFG_32BIT           0x00000000u
+
+#define GPTMTAMR_ONE_SHOT       0x00000001u
+#define GPTMTAMR_PERIODIC       0x00000002u
+#define GPTMTAMR_MODE_MASK      0x00000003u
+
+#define GPTMCTL_TAEN            0x00000001u
+#define GPTMCTL_TASTALL         0x00000002u
+
+#define GPTMIMR_TATOIM          0x00000001u
+#define GPTMICR_TATOCINT        0x00000001u
+
+/* Called from the timer's interrupt handler on each timeout - so it is
+ * to be kept short, and may start the timer again (e.g. the next event)
+ */
+typedef void (*gptm_callback)(gptm_id id, void* arg);
+
+void gptm_init(gptm_id id);
+bool gptm_start_periodic(gptm_id id, uint32_t period_us, gptm_callback callback, void* arg);
+bool gptm_start_one_shot(gptm_id id, uint32_t delay_us, gptm_callback callback, void* arg);
+void gptm_schedule_at(gptm_id id, uint64_t when_us, gptm_callback callback, void* arg);
+void gptm_stop(gptm_id id);
+bool gptm_running(gptm_id id);
+
+void gptm0_irq_handler(void);
+void gptm1_irq_handler(void);
+void gptm2_irq_handler(void);
+void gptm3_irq_handler(void);
+
+#endif /* __GPTM_H__ */
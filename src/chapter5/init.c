@@ -1,13 +1,18 @@
+#include <stdio.h>
 #include <stdint.h>
 #include "irq.h"
 #include "nvic.h"
 #include "sysctl.h"
 #include "systick.h"
+#include "cycle_counter.h"
+#include "trace.h"
+#include "stack_check.h"
 #include "system_time.h"
 #include "uart_drv.h"
 #include "serial_print.h"
 #include "task_scheduler.h"
 #include "example_tasks.h"
+#include "cyclic_exec.h"
 
 /* main() represents the entry point in a c program.
  * In this bare-metal system, main represents the 
@@ -19,6 +24,14 @@ int main(void)
 {
     const char *start_msg = "Hello, World\n";
     uint32_t clk_cfg1, clk_cfg2;
+    task_attr task0_attr = {0};
+    task_attr task1_attr = {0};
+    task_attr report_attr = {0};
+
+    /* Paint the unused main stack for the high-water mark - while the
+     * interrupts are still disabled, so no handler is using it meanwhile.
+     */
+    stack_check_paint_main();
 
     /* Let's now re-enable the interrupts*/
     irq_master_enable();
@@ -46,6 +59,12 @@ int main(void)
     systick_irq_enable();
     systick_enable();
 
+    /* The cycle counter times each task's execution for the scheduler's statistics */
+    cycle_counter_init();
+
+    /* Trace the scheduler from here on - Ctrl-T dumps the trace */
+    trace_start();
+
     /* Configure the uart to a baud-rate of 115200 */
     uart_init(UART_BAUD_115200);
 
@@ -59,10 +78,45 @@ int main(void)
     //serial_puts("\nGo on, say something...\n");
     //while(1);
 
-    task_scheduler_add_task(&example_task0, 5000u);
-    task_scheduler_add_task(&example_task1, 6000u);
+#ifdef CYCLIC_EXECUTIVE
+    /* The static build (make DEFS=-DCYCLIC_EXECUTIVE) - the schedule is the
+     * frame table generated from cyclic_tasks.def. Never returns.
+     */
+    cyclic_exec_run(&cyclic_schedule_table);
+#endif
+
+    task0_attr.start = &example_task0;
+    task0_attr.duration = 5000u;
+    task0_attr.priority = TASK_PRIO_DEFAULT;
+    task0_attr.wcet = 1100u;
+    task_scheduler_add_task_attr(&task0_attr, NULL);
+
+    task1_attr.start = &example_task1;
+    task1_attr.duration = 6000u;
+    task1_attr.priority = TASK_PRIO_DEFAULT - 1u;
+    task1_attr.wcet = 1100u;
+    task_scheduler_add_task_attr(&task1_attr, NULL);
+
+    report_attr.start = &example_report_task;
+    report_attr.duration = 30000u;
+    report_attr.priority = TASK_PRIO_LOWEST;
+    task_scheduler_add_task_attr(&report_attr, NULL);
+
+    /* Ctrl-T has the trace dumped from a task of it's own - at the lowest
+     * priority, it doesn't hold up the other tasks over the serial port.
+     */
+    trace_service_start(TASK_PRIO_LOWEST);
+
+    /* There's nothing to do for most of the 5 and 6 second periods -
+     * don't take a SysTick interrupt every millisecond through it.
+     */
+    task_scheduler_set_tickless(true);
 
-    task_scheduler_run();
+    /* Only returns if the SRAM left for task stacks doesn't fit them all */
+    if(task_scheduler_run_preemptive() != SCHEDULER_OKAY)
+    {
+        serial_puts("Not enough SRAM for the task stacks!\n");
+    }
     
     return 0;
 }
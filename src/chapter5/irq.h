@@ -1,6 +1,15 @@
 #ifndef __IRQ_H__
 #define __IRQ_H__
 
+#ifdef SIM_HOST
+
+/* The host simulation build - see sim/sim_irq.c */
+void irq_master_enable(void);
+void irq_master_disable(void);
+void irq_wait(void);
+
+#else
+
 /* To enable all interrupts with programmable priority.
  * Refer: Refer http://www.ti.com/lit/ds/symlink/lm3s6965.pdf
  * Table 2-13 and Section 2-3-4
@@ -25,4 +34,18 @@ static inline void irq_master_disable(void)
     __asm__ __volatile__ ("cpsid i");
 }
 
+/* Sleep until an interrupt is pending. With interrupts disabled, the
+ * interrupt still wakes the core - but is only taken once they are
+ * enabled again, so a check made before sleeping can't be raced.
+ * Refer: ARMv7-M Architecture Reference Manual Section B1.5.19
+ */
+static inline void irq_wait(void)
+{
+    __asm__ __volatile__ ("dsb\n"
+                          "wfi\n"
+                          "isb\n");
+}
+
+#endif /* SIM_HOST */
+
 #endif /* __IRQ_H__ */
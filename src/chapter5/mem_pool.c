@@ -0,0 +1,74 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "exclusive.h"
+#include "mem_pool.h"
+
+/* Set up a pool over storage for block_count blocks of block_size bytes -
+ * the block size is rounded up to a whole number of words. All the blocks
+ * start out free.
+ */
+void mem_pool_init(mem_pool* pool, void* storage, uint32_t block_size, uint16_t block_count) {
+    uint16_t idx;
+
+    block_size = (block_size + 3u) & ~3u;
+    if(block_size < sizeof(mem_block)) {
+        block_size = sizeof(mem_block);
+    }
+
+    pool->start = (uint8_t*)storage;
+    pool->block_size = block_size;
+    pool->block_count = block_count;
+    pool->free = NULL;
+
+    // thread the free list back to front, so the blocks are handed out in order
+    for(idx = block_count; idx > 0; idx--) {
+        mem_block* block = (mem_block*)&pool->start[(idx - 1u) * block_size];
+
+        block->next = pool->free;
+        pool->free = block;
+    }
+
+    pool->free_count = block_count;
+}
+
+/* Take a block from the pool - NULL if there are none free */
+void* mem_pool_alloc(mem_pool* pool) {
+    mem_block* block;
+
+    // an exclusive pop - not fooled by the block being taken and given back meanwhile
+    do {
+        block = (mem_block*)exclusive_load((volatile uint32_t*)&pool->free);
+
+        if(block == NULL) {
+            exclusive_clear();
+            return NULL;
+        }
+    }while(exclusive_store((volatile uint32_t*)&pool->free, (uint32_t)block->next) != 0);
+
+    __atomic_fetch_sub(&pool->free_count, 1u, __ATOMIC_RELAXED);
+
+    return block;
+}
+
+/* Give a block back to the pool it was taken from */
+void mem_pool_free(mem_pool* pool, void* block) {
+    mem_block* freed = (mem_block*)block;
+
+    do {
+        freed->next = (mem_block*)exclusive_load((volatile uint32_t*)&pool->free);
+    }while(exclusive_store((volatile uint32_t*)&pool->free, (uint32_t)freed) != 0);
+
+    __atomic_fetch_add(&pool->free_count, 1u, __ATOMIC_RELAXED);
+}
+
+/* Whether block is one of the pool's blocks */
+bool mem_pool_owns(const mem_pool* pool, const void* block) {
+    const uint8_t* addr = (const uint8_t*)block;
+
+    if(addr < pool->start || addr >= &pool->start[pool->block_count * pool->block_size]) {
+        return false;
+    }
+
+    return ((uint32_t)(addr - pool->start) % pool->block_size) == 0;
+}
@@ -0,0 +1,34 @@
+#ifndef __MEM_POOL_H__
+#define __MEM_POOL_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* A pool of fixed size blocks - taken and given back in O(1) from tasks
+ * and interrupt handlers alike, without disabling interrupts.
+ * A free block holds the link to the next free block in it's first word.
+ */
+typedef struct mem_block mem_block;
+
+struct mem_block{
+    mem_block*          next;
+};
+
+typedef struct{
+    mem_block* volatile free;
+    uint8_t*            start;
+    uint32_t            block_size;     // in bytes, a multiple of 4
+    uint16_t            block_count;
+    volatile uint16_t   free_count;
+}mem_pool;
+
+/* Statically define the (word aligned) storage of a pool of count blocks of size bytes */
+#define MEM_POOL_STORAGE(name, size, count) \
+    static uint32_t name[(count) * (((size) + 3u) / 4u)]
+
+void mem_pool_init(mem_pool* pool, void* storage, uint32_t block_size, uint16_t block_count);
+void* mem_pool_alloc(mem_pool* pool);
+void mem_pool_free(mem_pool* pool, void* block);
+bool mem_pool_owns(const mem_pool* pool, const void* block);
+
+#endif /* __MEM_POOL_H__ */
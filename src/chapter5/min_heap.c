@@ -0,0 +1,131 @@
+#include <stdio.h>
+#include "min_heap.h"
+
+/* Wrap-safe comparison of two points in systime_t */
+static inline bool heap_key_before(systime_t a, systime_t b) {
+    return systime_before(a, b);
+}
+
+/* Place a node at a given position of the heap array */
+static inline void heap_set(min_heap* heap, uint16_t idx, heap_node* node) {
+    heap->nodes[idx] = node;
+    node->idx = idx;
+}
+
+/* Move the node at idx up towards the root until it's parent is no later */
+static void heap_sift_up(min_heap* heap, uint16_t idx) {
+    heap_node* node = heap->nodes[idx];
+
+    while(idx > 0) {
+        uint16_t parent = (idx - 1u) / 2u;
+
+        if(!heap_key_before(node->key, heap->nodes[parent]->key)) {
+            break;
+        }
+
+        heap_set(heap, idx, heap->nodes[parent]);
+        idx = parent;
+    }
+
+    heap_set(heap, idx, node);
+}
+
+/* Move the node at idx down until neither of it's children is earlier */
+static void heap_sift_down(min_heap* heap, uint16_t idx) {
+    heap_node* node = heap->nodes[idx];
+
+    while(1) {
+        uint16_t child = 2u * idx + 1u;
+
+        if(child >= heap->count) {
+            break;
+        }
+
+        if(child + 1u < heap->count &&
+           heap_key_before(heap->nodes[child + 1u]->key, heap->nodes[child]->key)) {
+            child++;
+        }
+
+        if(!heap_key_before(heap->nodes[child]->key, node->key)) {
+            break;
+        }
+
+        heap_set(heap, idx, heap->nodes[child]);
+        idx = child;
+    }
+
+    heap_set(heap, idx, node);
+}
+
+/* Set up an empty heap over an array of capacity node pointers */
+void min_heap_init(min_heap* heap, heap_node** storage, uint16_t capacity) {
+    heap->nodes = storage;
+    heap->count = 0;
+    heap->capacity = capacity;
+}
+
+/* Queue a node with the given key - O(log n).
+ * Returns false if the heap is full.
+ */
+bool min_heap_insert(min_heap* heap, heap_node* node, systime_t key) {
+    if(heap->count >= heap->capacity) {
+        return false;
+    }
+
+    node->key = key;
+    heap_set(heap, heap->count, node);
+    heap->count++;
+    heap_sift_up(heap, node->idx);
+
+    return true;
+}
+
+/* The node with the earliest key - NULL if the heap is empty */
+heap_node* min_heap_peek(const min_heap* heap) {
+    if(heap->count == 0) {
+        return NULL;
+    }
+
+    return heap->nodes[0];
+}
+
+/* Remove and return the node with the earliest key - O(log n).
+ * Returns NULL if the heap is empty.
+ */
+heap_node* min_heap_pop(min_heap* heap) {
+    heap_node* node = min_heap_peek(heap);
+
+    if(node != NULL) {
+        min_heap_remove(heap, node);
+    }
+
+    return node;
+}
+
+/* Remove a queued node from anywhere in the heap - O(log n) */
+void min_heap_remove(min_heap* heap, heap_node* node) {
+    uint16_t idx = node->idx;
+    heap_node* last;
+
+    if(idx == HEAP_NOT_QUEUED) {
+        return;
+    }
+
+    heap->count--;
+    last = heap->nodes[heap->count];
+    node->idx = HEAP_NOT_QUEUED;
+
+    if(last == node) {
+        return;
+    }
+
+    // fill the hole with the last node and restore the heap order around it
+    heap_set(heap, idx, last);
+
+    if(idx > 0 && heap_key_before(last->key, heap->nodes[(idx - 1u) / 2u]->key)) {
+        heap_sift_up(heap, idx);
+    }
+    else {
+        heap_sift_down(heap, idx);
+    }
+}
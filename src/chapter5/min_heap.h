@@ -0,0 +1,45 @@
+#ifndef __MIN_HEAP_H__
+#define __MIN_HEAP_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "system_time.h"
+
+#define HEAP_NOT_QUEUED     (0xFFFFu)
+
+/* Get a pointer to the structure a heap_node is embedded in */
+#define HEAP_ENTRY(node, type, member)  ((type*)((uint8_t*)(node) - offsetof(type, member)))
+
+/* A node of the heap - meant to be embedded in the structure being queued
+ * (a task descriptor, a timer...) so that queueing never needs to allocate.
+ * The key is a point in systime_t, compared wrap-safe - so all keys in
+ * a heap need to be within half the systime_t range of each other.
+ */
+typedef struct{
+    systime_t   key;
+    uint16_t    idx;
+}heap_node;
+
+/* A binary min-heap of nodes in a caller provided array */
+typedef struct{
+    heap_node** nodes;
+    uint16_t    count;
+    uint16_t    capacity;
+}min_heap;
+
+/* None of these functions are re-entrant - a heap shared with an
+ * interrupt handler is to be accessed with interrupts disabled.
+ */
+void min_heap_init(min_heap* heap, heap_node** storage, uint16_t capacity);
+bool min_heap_insert(min_heap* heap, heap_node* node, systime_t key);
+heap_node* min_heap_peek(const min_heap* heap);
+heap_node* min_heap_pop(min_heap* heap);
+void min_heap_remove(min_heap* heap, heap_node* node);
+
+static inline bool min_heap_queued(const heap_node* node)
+{
+    return node->idx != HEAP_NOT_QUEUED;
+}
+
+#endif /* __MIN_HEAP_H__ */
@@ -0,0 +1,77 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "irq.h"
+#include "task_event.h"
+#include "trace.h"
+#include "msg_queue.h"
+
+/* Set up an empty queue over an array of capacity message pointers */
+void msg_queue_init(msg_queue* queue, void** slots, uint16_t capacity) {
+    queue->slots = slots;
+    queue->capacity = capacity;
+    queue->head = 0;
+    queue->count = 0;
+    task_event_init(&queue->not_empty);
+}
+
+/* Queue a message - from a task or an interrupt handler.
+ * Only the pointer is queued, the message itself isn't copied.
+ * Returns false if the queue is full.
+ */
+bool msg_queue_send(msg_queue* queue, void* msg) {
+    uint16_t tail;
+
+    irq_master_disable();
+
+    if(queue->count >= queue->capacity) {
+        irq_master_enable();
+        return false;
+    }
+
+    tail = queue->head + queue->count;
+    if(tail >= queue->capacity) {
+        tail -= queue->capacity;
+    }
+
+    queue->slots[tail] = msg;
+    queue->count++;
+
+    trace_record(TRACE_QUEUE_SEND, trace_sat(queue->count), trace_obj(queue));
+
+    irq_master_enable();
+
+    task_event_signal(&queue->not_empty);
+
+    return true;
+}
+
+/* Take the oldest message off the queue, without waiting.
+ * Returns false if the queue is empty.
+ */
+bool msg_queue_receive(msg_queue* queue, void** msg) {
+    irq_master_disable();
+
+    if(queue->count == 0) {
+        irq_master_enable();
+        return false;
+    }
+
+    *msg = queue->slots[queue->head];
+    queue->head++;
+    if(queue->head >= queue->capacity) {
+        queue->head = 0;
+    }
+    queue->count--;
+
+    trace_record(TRACE_QUEUE_RECEIVE, trace_sat(queue->count), trace_obj(queue));
+
+    irq_master_enable();
+
+    return true;
+}
+
+/* The number of messages queued */
+uint16_t msg_queue_count(const msg_queue* queue) {
+    return queue->count;
+}
@@ -0,0 +1,27 @@
+#ifndef __MSG_QUEUE_H__
+#define __MSG_QUEUE_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "task_event.h"
+
+/* A queue of messages passed by reference - typically blocks of a mem_pool,
+ * so a payload is written once by the sender and read in place by the
+ * receiver. Tasks and interrupt handlers may send, tasks receive - waiting
+ * with task_receive() in task_coroutine.h while the queue is empty.
+ * Ownership of a message passes with it - the receiver frees the block.
+ */
+typedef struct{
+    void**              slots;
+    uint16_t            capacity;
+    uint16_t            head;
+    volatile uint16_t   count;
+    task_event          not_empty;
+}msg_queue;
+
+void msg_queue_init(msg_queue* queue, void** slots, uint16_t capacity);
+bool msg_queue_send(msg_queue* queue, void* msg);
+bool msg_queue_receive(msg_queue* queue, void** msg);
+uint16_t msg_queue_count(const msg_queue* queue);
+
+#endif /* __MSG_QUEUE_H__ */
@@ -45,15 +45,17 @@ static volatile nvic_regs *nvic = (nvic_regs*)NVIC_BASE;
  */
 void nvic_irq_enable(uint32_t vector_num)
 {
-    /* Interrupts 0-31 enabled via EN0 */
-    if(vector_num >= IRQ_GPIOA && vector_num <= IRQ_ADC0_SEQ1) 
+    /* Interrupts 0-31 (vectors 16-47) enabled via EN0.
+     * Writing a 0 bit has no effect - so only the one bit is written.
+     */
+    if(vector_num >= IRQ_GPIOA && vector_num <= NVIC_EN0_LAST_VECTOR) 
     {
-        nvic->EN0 |= (1 << (vector_num - IRQ_GPIOA));
+        nvic->EN0 = (1u << (vector_num - IRQ_GPIOA));
     }
-    /* Interrupts 31-43 enabled via EN1 */
-    else if(vector_num >= IRQ_ADC0_SEQ2 && vector_num <= IRQ_HIBERNATE) 
+    /* Interrupts 32-43 (vectors 48-59) enabled via EN1 */
+    else if(vector_num > NVIC_EN0_LAST_VECTOR && vector_num <= IRQ_HIBERNATE) 
     {
-        nvic->EN1 |= (1 << (vector_num - IRQ_ADC0_SEQ2));
+        nvic->EN1 = (1u << (vector_num - NVIC_EN0_LAST_VECTOR - 1u));
     }
 
 }
@@ -64,14 +66,16 @@ void nvic_irq_enable(uint32_t vector_num)
  */
 void nvic_irq_disable(uint32_t vector_num)
 {
-    /* Interrupts 0-31 disabled via DIS0 */
-    if(vector_num >= IRQ_GPIOA && vector_num <= IRQ_ADC0_SEQ1) 
+    /* Interrupts 0-31 (vectors 16-47) disabled via DIS0.
+     * Writing a 0 bit has no effect - so only the one bit is written.
+     */
+    if(vector_num >= IRQ_GPIOA && vector_num <= NVIC_EN0_LAST_VECTOR) 
     {
-        nvic->DIS0 |= (1 << (vector_num - IRQ_GPIOA));
+        nvic->DIS0 = (1u << (vector_num - IRQ_GPIOA));
     }
-    /* Interrupts 31-43 disabled via DIS1 */
-    else if(vector_num >= IRQ_ADC0_SEQ2 && vector_num <= IRQ_HIBERNATE) 
+    /* Interrupts 32-43 (vectors 48-59) disabled via DIS1 */
+    else if(vector_num > NVIC_EN0_LAST_VECTOR && vector_num <= IRQ_HIBERNATE) 
     {
-        nvic->DIS1 |= (1 << (vector_num - IRQ_ADC0_SEQ2));
+        nvic->DIS1 = (1u << (vector_num - NVIC_EN0_LAST_VECTOR - 1u));
     }
 }
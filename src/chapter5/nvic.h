@@ -55,6 +55,9 @@
 #define IRQ_ETH             58u         // Ethernet Controller
 #define IRQ_HIBERNATE       59u         // Hibernate Module
 
+// the last vector enabled/disabled via EN0/DIS0 - interrupt 31
+#define NVIC_EN0_LAST_VECTOR    47u
+
 void nvic_irq_enable(uint32_t vector_num);
 void nvic_irq_disable(uint32_t vector_num);
 
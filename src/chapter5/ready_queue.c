@@ -0,0 +1,113 @@
+#include <stdio.h>
+#include "ready_queue.h"
+
+#define PRIO_BIT(prio)      (0x80000000u >> (prio))
+
+static uint32_t ready_bitmap;
+static task_desc* ready_head[TASK_PRIO_LEVELS];
+static task_desc* ready_tail[TASK_PRIO_LEVELS];
+
+/* Add a task to the back of it's priority level's list */
+void ready_queue_push(task_desc* task) {
+    uint8_t prio = task->priority;
+
+    task->next = NULL;
+
+    if(ready_head[prio] == NULL) {
+        ready_head[prio] = task;
+    }
+    else {
+        ready_tail[prio]->next = task;
+    }
+
+    ready_tail[prio] = task;
+    ready_bitmap |= PRIO_BIT(prio);
+}
+
+/* Add a task to the front of it's priority level's list - used for
+ * a preempted task so it resumes ahead of it's peers.
+ */
+void ready_queue_push_front(task_desc* task) {
+    uint8_t prio = task->priority;
+
+    task->next = ready_head[prio];
+
+    if(ready_head[prio] == NULL) {
+        ready_tail[prio] = task;
+    }
+
+    ready_head[prio] = task;
+    ready_bitmap |= PRIO_BIT(prio);
+}
+
+/* Remove and return the task at the front of the highest priority level.
+ * Returns NULL if no task is ready.
+ */
+task_desc* ready_queue_pop(void) {
+    task_desc* task;
+    uint8_t prio;
+
+    if(ready_bitmap == 0) {
+        return NULL;
+    }
+
+    prio = (uint8_t)__builtin_clz(ready_bitmap);
+    task = ready_head[prio];
+
+    ready_head[prio] = task->next;
+
+    if(ready_head[prio] == NULL) {
+        ready_tail[prio] = NULL;
+        ready_bitmap &= ~PRIO_BIT(prio);
+    }
+
+    task->next = NULL;
+
+    return task;
+}
+
+/* Remove a task from anywhere in it's priority level's list -
+ * O(n) in the number of tasks ready at that level.
+ */
+void ready_queue_remove(task_desc* task) {
+    uint8_t prio = task->priority;
+    task_desc* prev = NULL;
+    task_desc* curr = ready_head[prio];
+
+    while(curr != NULL && curr != task) {
+        prev = curr;
+        curr = curr->next;
+    }
+
+    if(curr == NULL) {
+        return;
+    }
+
+    if(prev == NULL) {
+        ready_head[prio] = task->next;
+    }
+    else {
+        prev->next = task->next;
+    }
+
+    if(ready_tail[prio] == task) {
+        ready_tail[prio] = prev;
+    }
+
+    if(ready_head[prio] == NULL) {
+        ready_bitmap &= ~PRIO_BIT(prio);
+    }
+
+    task->next = NULL;
+}
+
+/* The highest priority with a ready task -
+ * TASK_PRIO_LEVELS if no task is ready.
+ */
+uint8_t ready_queue_highest_prio(void) {
+    if(ready_bitmap == 0) {
+        return TASK_PRIO_LEVELS;
+    }
+
+    return (uint8_t)__builtin_clz(ready_bitmap);
+}
@@ -0,0 +1,22 @@
+#ifndef __READY_QUEUE_H__
+#define __READY_QUEUE_H__
+
+#include <stdint.h>
+#include "task_scheduler.h"
+
+/* The ready queue keeps a FIFO list of ready tasks per priority level
+ * and a bitmap of the levels that have at least one ready task -
+ * bit 31 for priority 0 down to bit 0 for priority 31. This way,
+ * count leading zeros on the bitmap gives the highest ready priority.
+ *
+ * None of these functions are re-entrant - they are to be called
+ * with interrupts disabled.
+ */
+
+void ready_queue_push(task_desc* task);
+void ready_queue_push_front(task_desc* task);
+task_desc* ready_queue_pop(void);
+void ready_queue_remove(task_desc* task);
+uint8_t ready_queue_highest_prio(void);
+
+#endif /* __READY_QUEUE_H__ */
@@ -0,0 +1,138 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "ring_buffer.h"
+
+/* Data Memory Barrier - the elements must be in memory before the head
+ * says they are there, and read before the tail gives them back.
+ * A single Cortex-M3 doesn't reorder it's own accesses to normal memory,
+ * but the barrier also keeps the compiler from doing so - and keeps the
+ * buffer correct shared with a DMA or another bus master.
+ */
+static inline void ring_buffer_barrier(void) {
+#ifdef SIM_HOST
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+#else
+    __asm__ __volatile__ ("dmb" ::: "memory");
+#endif
+}
+
+/* Copy bytes - there is no C library to take memcpy() from */
+static void ring_buffer_copy(uint8_t* dst, const uint8_t* src, uint32_t len) {
+    while(len--) {
+        *dst++ = *src++;
+    }
+}
+
+/* Set up an empty ring buffer over storage of capacity elements.
+ * Returns false if the capacity isn't a power of two.
+ */
+bool ring_buffer_init(ring_buffer* ring, void* storage, uint32_t capacity, uint32_t elem_size) {
+    if(capacity == 0 || (capacity & (capacity - 1u)) != 0) {
+        return false;
+    }
+
+    ring->storage = (uint8_t*)storage;
+    ring->capacity = capacity;
+    ring->elem_size = elem_size;
+    ring->head = 0;
+    ring->tail = 0;
+
+    return true;
+}
+
+/* The number of elements waiting to be popped */
+uint32_t ring_buffer_count(const ring_buffer* ring) {
+    return ring->head - ring->tail;
+}
+
+/* The number of elements that can be pushed */
+uint32_t ring_buffer_space(const ring_buffer* ring) {
+    return ring->capacity - (ring->head - ring->tail);
+}
+
+/* Push an element - producer side only.
+ * Returns false if the buffer is full.
+ */
+bool ring_buffer_push(ring_buffer* ring, const void* elem) {
+    return ring_buffer_write(ring, elem, 1u) == 1u;
+}
+
+/* Pop the oldest element - consumer side only.
+ * Returns false if the buffer is empty.
+ */
+bool ring_buffer_pop(ring_buffer* ring, void* elem) {
+    return ring_buffer_read(ring, elem, 1u) == 1u;
+}
+
+/* Push up to count elements in one go - producer side only.
+ * The elements are copied in at most two runs (either side of the wrap)
+ * and published with a single update of the head.
+ * Returns the number of elements pushed.
+ */
+uint32_t ring_buffer_write(ring_buffer* ring, const void* elems, uint32_t count) {
+    const uint8_t* src = (const uint8_t*)elems;
+    uint32_t head = ring->head;
+    uint32_t space = ring->capacity - (head - ring->tail);
+    uint32_t idx, run;
+
+    if(count > space) {
+        count = space;
+    }
+
+    if(count == 0) {
+        return 0;
+    }
+
+    // the tail read above, before overwriting any of the elements it freed
+    ring_buffer_barrier();
+
+    idx = head & (ring->capacity - 1u);
+    run = ring->capacity - idx;
+    if(run > count) {
+        run = count;
+    }
+
+    ring_buffer_copy(&ring->storage[idx * ring->elem_size], src, run * ring->elem_size);
+    ring_buffer_copy(ring->storage, &src[run * ring->elem_size], (count - run) * ring->elem_size);
+
+    ring_buffer_barrier();
+    ring->head = head + count;
+
+    return count;
+}
+
+/* Pop up to count of the oldest elements in one go - consumer side only.
+ * Returns the number of elements popped.
+ */
+uint32_t ring_buffer_read(ring_buffer* ring, void* elems, uint32_t count) {
+    uint8_t* dst = (uint8_t*)elems;
+    uint32_t tail = ring->tail;
+    uint32_t avail = ring->head - tail;
+    uint32_t idx, run;
+
+    if(count > avail) {
+        count = avail;
+    }
+
+    if(count == 0) {
+        return 0;
+    }
+
+    // the head read above, before any of the elements it covers
+    ring_buffer_barrier();
+
+    idx = tail & (ring->capacity - 1u);
+    run = ring->capacity - idx;
+    if(run > count) {
+        run = count;
+    }
+
+    ring_buffer_copy(dst, &ring->storage[idx * ring->elem_size], run * ring->elem_size);
+    ring_buffer_copy(&dst[run * ring->elem_size], ring->storage, (count - run) * ring->elem_size);
+
+    ring_buffer_barrier();
+    ring->tail = tail + count;
+
+    return count;
+}
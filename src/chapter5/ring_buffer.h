@@ -0,0 +1,34 @@
+#ifndef __RING_BUFFER_H__
+#define __RING_BUFFER_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Single-producer/single-consumer ring buffer of fixed size elements.
+ * One side (typically an interrupt handler) only ever pushes and the other
+ * (typically a task) only ever pops - neither needs interrupts disabled.
+ * The capacity must be a power of two - the head and tail are free-running
+ * counts, masked into the storage, so all of it is usable.
+ */
+typedef struct{
+    uint8_t*            storage;
+    uint32_t            capacity;       // in elements
+    uint32_t            elem_size;      // in bytes
+    volatile uint32_t   head;           // moved by the producer only
+    volatile uint32_t   tail;           // moved by the consumer only
+}ring_buffer;
+
+/* Statically define the storage and ring buffer name - of capacity elements of type */
+#define RING_BUFFER_DEFINE(name, type, cap)                                 \
+    static uint8_t name##_storage[(cap) * sizeof(type)];                   \
+    static ring_buffer name = { name##_storage, (cap), sizeof(type), 0, 0 }
+
+bool ring_buffer_init(ring_buffer* ring, void* storage, uint32_t capacity, uint32_t elem_size);
+uint32_t ring_buffer_count(const ring_buffer* ring);
+uint32_t ring_buffer_space(const ring_buffer* ring);
+bool ring_buffer_push(ring_buffer* ring, const void* elem);
+bool ring_buffer_pop(ring_buffer* ring, void* elem);
+uint32_t ring_buffer_write(ring_buffer* ring, const void* elems, uint32_t count);
+uint32_t ring_buffer_read(ring_buffer* ring, void* elems, uint32_t count);
+
+#endif /* __RING_BUFFER_H__ */
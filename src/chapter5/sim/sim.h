@@ -0,0 +1,46 @@
+#ifndef __SIM_H__
+#define __SIM_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* The host simulation build (make sim) - the scheduler, the kernel objects
+ * and the example tasks built as a native program, with the hardware they
+ * touch replaced by a virtual clock. Nothing waits on real time: the clock
+ * jumps ahead whenever the simulated CPU sleeps, so weeks of system time
+ * run in seconds - and as nothing depends on the host, every run of the
+ * same build with the same options gives the same output.
+ */
+
+/* The simulated system clock - as the firmware configures it in init.c
+ * (16.67 MHz), with the 1 ms SysTick period systick_set_period_ms() sets.
+ */
+#define SIM_CLOCK_HZ            16666666u
+#define SIM_TICK_CYCLES         ((SIM_CLOCK_HZ / 1000u) + 1u)
+
+/* Cycles charged to each read of the cycle counter - standing in for the
+ * code run in between, so the execution time statistics and the CPU load
+ * aren't all 0. Time passes otherwise only when the CPU sleeps.
+ */
+#define SIM_READ_CYCLES         (64u)
+
+// sim_clock.c
+void sim_clock_advance(uint32_t cycles);
+void sim_clock_sleep(void);
+bool sim_clock_take_tick(void);
+uint64_t sim_clock_cycles(void);
+
+// sim_irq.c
+void sim_irq_poll(void);
+void sim_irq_set_disable_hook(void (*hook)(void));
+
+// sim_console.c
+void sim_console_quiet(bool quiet);
+
+// sim_sram.c
+bool sim_static_below_4g(void);
+
+// sim_main.c, sim_test.c - each program's own
+void sim_tick(void);
+
+#endif /* __SIM_H__ */
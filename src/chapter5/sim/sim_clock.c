@@ -0,0 +1,123 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "systick.h"
+#include "cycle_counter.h"
+#include "sim.h"
+
+/* The virtual clock - the cycles of the system clock since startup and
+ * where the next SysTick period ends. A period that ends leaves it's
+ * interrupt pending until sim_irq.c takes it.
+ */
+static uint64_t sim_cycles;
+static uint64_t sim_next_tick = SIM_TICK_CYCLES;
+static uint32_t sim_ticks_pending;
+
+/* Move the clock on by some cycles of the CPU running - the SysTick
+ * periods that end meanwhile are taken as soon as interrupts are enabled.
+ */
+void sim_clock_advance(uint32_t cycles) {
+    sim_cycles += cycles;
+
+    while(sim_cycles >= sim_next_tick) {
+        sim_ticks_pending++;
+        sim_next_tick += SIM_TICK_CYCLES;
+    }
+
+    sim_irq_poll();
+}
+
+/* Sleep until an interrupt is pending - the only source of them in the
+ * simulation is the SysTick, so this is to the end of the current period.
+ */
+void sim_clock_sleep(void) {
+    if(sim_ticks_pending == 0) {
+        sim_cycles = sim_next_tick;
+        sim_next_tick += SIM_TICK_CYCLES;
+        sim_ticks_pending++;
+    }
+}
+
+/* Take a pending SysTick interrupt - false if there is none */
+bool sim_clock_take_tick(void) {
+    if(sim_ticks_pending == 0) {
+        return false;
+    }
+
+    sim_ticks_pending--;
+    return true;
+}
+
+/* The cycles since startup - without charging for the read */
+uint64_t sim_clock_cycles(void) {
+    return sim_cycles;
+}
+
+/* The SysTick and cycle counter drivers' interface, off the virtual clock */
+
+void systick_enable(void) {
+}
+
+void systick_disable(void) {
+}
+
+void systick_irq_enable(void) {
+}
+
+void systick_irq_disable(void) {
+}
+
+void systick_set_period_ms(uint32_t millisec) {
+    (void)millisec;
+}
+
+uint32_t systick_get_period(void) {
+    return SIM_TICK_CYCLES;
+}
+
+uint32_t systick_get_current(void) {
+    return (uint32_t)(sim_next_tick - sim_cycles) - 1u;
+}
+
+bool systick_irq_pending(void) {
+    return sim_ticks_pending != 0;
+}
+
+/* The tickless sleep - nothing but the SysTick wakes the simulated CPU,
+ * so it always sleeps through to the end of the last period. As on the
+ * hardware, at most as many periods as the 24-bit reload value holds.
+ * To be called with interrupts disabled.
+ */
+uint32_t systick_sleep_ticks(uint32_t ticks) {
+    uint32_t max_ticks = STRELOAD_MASK / SIM_TICK_CYCLES;
+
+    if(ticks > max_ticks) {
+        ticks = max_ticks;
+    }
+
+    if(ticks < 2u) {
+        return 0;
+    }
+
+    sim_cycles = sim_next_tick + (uint64_t)(ticks - 1u) * SIM_TICK_CYCLES;
+    sim_next_tick = sim_cycles + SIM_TICK_CYCLES;
+    sim_ticks_pending++;
+
+    return ticks - 1u;
+}
+
+void cycle_counter_init(void) {
+}
+
+uint32_t cycle_counter_get(void) {
+    sim_clock_advance(SIM_READ_CYCLES);
+    return (uint32_t)sim_cycles;
+}
+
+uint32_t cycle_counter_hz(void) {
+    return SIM_CLOCK_HZ;
+}
+
+bool cycle_counter_is_dwt(void) {
+    return true;
+}
@@ -0,0 +1,29 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "uart_drv.h"
+#include "sim.h"
+
+/* The UART - what is sent goes to the standard output, nothing is received */
+static bool console_quiet;
+
+/* Drop everything sent from here on - for long runs */
+void sim_console_quiet(bool quiet) {
+    console_quiet = quiet;
+}
+
+void uart_init(uint32_t baudrate) {
+    (void)baudrate;
+}
+
+void uart_tx_byte(uint8_t byte) {
+    if(!console_quiet) {
+        putchar(byte);
+    }
+}
+
+uart_err uart_rx_byte(uint8_t* byte) {
+    (void)byte;
+
+    return UART_NO_DATA;
+}
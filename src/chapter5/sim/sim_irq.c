@@ -0,0 +1,107 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include "irq.h"
+#include "context_switch.h"
+#include "work_queue.h"
+#include "system_time.h"
+#include "task_scheduler.h"
+#include "sim.h"
+
+/* The simulated interrupts - the SysTick and PendSV. They are taken when
+ * interrupts are enabled with one pending, the SysTick first, each run to
+ * completion - a handler is never preempted, as neither can preempt the
+ * other at the default priorities. Out of reset interrupts are disabled.
+ */
+static bool irq_disabled = true;
+static bool irq_in_handler;
+static bool pendsv_pending;
+
+/* Called whenever the code outside the handlers disables interrupts - for
+ * a test to have an interrupt come at a point of it's choosing, while they
+ * are disabled. It's taken as soon as they are enabled again.
+ */
+static void (*irq_disable_hook)(void);
+
+/* Take the pending interrupts - unless they are disabled or we are in a handler */
+void sim_irq_poll(void) {
+    if(irq_disabled || irq_in_handler) {
+        return;
+    }
+
+    irq_in_handler = true;
+
+    while(1) {
+        if(sim_clock_take_tick()) {
+            system_time_incr();
+            task_scheduler_tick();
+            sim_tick();
+        }
+        else if(pendsv_pending) {
+            pendsv_pending = false;
+            work_queue_run();
+        }
+        else {
+            break;
+        }
+    }
+
+    irq_in_handler = false;
+}
+
+void irq_master_enable(void) {
+    irq_disabled = false;
+    sim_irq_poll();
+}
+
+void irq_master_disable(void) {
+    irq_disabled = true;
+
+    if(irq_disable_hook != NULL && !irq_in_handler) {
+        irq_disable_hook();
+    }
+}
+
+void sim_irq_set_disable_hook(void (*hook)(void)) {
+    irq_disable_hook = hook;
+}
+
+/* Sleep until an interrupt is pending - taken once interrupts are enabled */
+void irq_wait(void) {
+    if(!pendsv_pending) {
+        sim_clock_sleep();
+    }
+
+    sim_irq_poll();
+}
+
+/* The context switch interface - PendSV runs the deferred work only,
+ * as the simulation has the cooperative mode only: the tasks all run
+ * on the one (host) stack.
+ */
+void context_switch_init(void) {
+}
+
+void context_switch_request(void) {
+    context_switch_pend();
+}
+
+void context_switch_pend(void) {
+    pendsv_pending = true;
+}
+
+uint32_t* context_switch_stack_init(uint32_t* stack_top, context_entry_fptr entry, void* arg) {
+    (void)entry;
+    (void)arg;
+
+    return stack_top;
+}
+
+void context_switch_start(uint32_t* psp, void (*idle)(void)) {
+    (void)psp;
+    (void)idle;
+
+    fputs("sim: the preemptive mode isn't simulated\n", stderr);
+    exit(EXIT_FAILURE);
+}
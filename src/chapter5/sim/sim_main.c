@@ -0,0 +1,126 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include "irq.h"
+#include "system_time.h"
+#include "task_scheduler.h"
+#include "example_tasks.h"
+#include "sim.h"
+
+static task_desc* sim_tasks[3];
+static uint64_t sim_start;
+static uint64_t sim_end;
+static struct timespec sim_host_start;
+
+/* The end of the run - a line of results, one key=value per field:
+ * the system time it started and ended at (ms), the task releases run,
+ * the host time taken in all and per release (ns), the deadline misses
+ * and the CPU load at the end (hundredths of a percent). All but the
+ * host times are the same from run to run.
+ */
+static void sim_finish(void) {
+    struct timespec host_end;
+    task_stats stats;
+    uint64_t host_ns;
+    uint64_t releases = 0;
+    uint32_t idx;
+
+    clock_gettime(CLOCK_MONOTONIC, &host_end);
+    host_ns = (uint64_t)(host_end.tv_sec - sim_host_start.tv_sec) * 1000000000u +
+              (uint64_t)host_end.tv_nsec - (uint64_t)sim_host_start.tv_nsec;
+
+    for(idx = 0; idx < sizeof(sim_tasks) / sizeof(sim_tasks[0]); idx++) {
+        task_scheduler_get_stats(sim_tasks[idx], &stats);
+        releases += stats.run_count;
+    }
+
+    fflush(stdout);
+    printf("sim: start_ms=%llu end_ms=%llu releases=%llu host_ns=%llu ns_per_release=%llu misses=%u load=%u\n",
+           (unsigned long long)sim_start, (unsigned long long)system_time_get64(),
+           (unsigned long long)releases, (unsigned long long)host_ns,
+           (unsigned long long)(releases ? host_ns / releases : 0),
+           task_scheduler_total_misses(), task_scheduler_cpu_load());
+
+    exit(EXIT_SUCCESS);
+}
+
+/* Called after each SysTick interrupt - ends the run once it's time is up */
+void sim_tick(void) {
+    if(system_time_get64() - sim_start >= sim_end) {
+        sim_finish();
+    }
+}
+
+static void sim_usage(const char* name) {
+    fprintf(stderr, "usage: %s [-t run_ms] [-s start_ms] [-q]\n"
+                    "  -t  system time to run for (default 60000)\n"
+                    "  -s  system time to start at - e.g. 4294960000 to run across the 32-bit wrap\n"
+                    "  -q  drop the console output\n", name);
+    exit(EXIT_FAILURE);
+}
+
+/* The example tasks of init.c, run in the cooperative mode */
+int main(int argc, char* argv[]) {
+    task_attr task0_attr = {0};
+    task_attr task1_attr = {0};
+    task_attr report_attr = {0};
+    int opt;
+
+    sim_end = 60000u;
+
+    while((opt = getopt(argc, argv, "t:s:q")) != -1) {
+        switch(opt) {
+            case 't':
+                sim_end = strtoull(optarg, NULL, 0);
+                break;
+            case 's':
+                sim_start = strtoull(optarg, NULL, 0);
+                break;
+            case 'q':
+                sim_console_quiet(true);
+                break;
+            default:
+                sim_usage(argv[0]);
+        }
+    }
+
+    if(!sim_static_below_4g()) {
+        fputs("sim: static data above 4 GiB - link with -no-pie\n", stderr);
+        return EXIT_FAILURE;
+    }
+
+    if(sim_start > 0xFFFFFFFFu) {
+        fputs("sim: the start time has to fit in 32 bits\n", stderr);
+        return EXIT_FAILURE;
+    }
+
+    system_time_advance((systime_t)sim_start);
+
+    task0_attr.start = &example_task0;
+    task0_attr.duration = 5000u;
+    task0_attr.priority = TASK_PRIO_DEFAULT;
+    task0_attr.wcet = 1100u;
+    task_scheduler_add_task_attr(&task0_attr, &sim_tasks[0]);
+
+    task1_attr.start = &example_task1;
+    task1_attr.duration = 6000u;
+    task1_attr.priority = TASK_PRIO_DEFAULT - 1u;
+    task1_attr.wcet = 1100u;
+    task_scheduler_add_task_attr(&task1_attr, &sim_tasks[1]);
+
+    report_attr.start = &example_report_task;
+    report_attr.duration = 30000u;
+    report_attr.priority = TASK_PRIO_LOWEST;
+    task_scheduler_add_task_attr(&report_attr, &sim_tasks[2]);
+
+    task_scheduler_set_tickless(true);
+
+    clock_gettime(CLOCK_MONOTONIC, &sim_host_start);
+    irq_master_enable();
+    task_scheduler_run();
+
+    return EXIT_SUCCESS;
+}
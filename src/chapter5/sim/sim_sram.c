@@ -0,0 +1,19 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "sim.h"
+
+/* Stand-ins for the SRAM regions of the linker script - no room for task
+ * stacks (the cooperative mode needs none) and an empty main stack.
+ */
+uint32_t _sram_task_stacks;
+extern uint32_t _sram_task_stacks_end __attribute__((alias("_sram_task_stacks")));
+extern uint32_t _sram_stacktop __attribute__((alias("_sram_task_stacks")));
+
+/* The kernel keeps pointers in 32-bit words here and there, as they are
+ * on the target. Linked as a position dependent executable, all of the
+ * static data - and so every kernel object - is below 4 GiB.
+ */
+bool sim_static_below_4g(void) {
+    return (uintptr_t)&_sram_task_stacks <= 0xFFFFFFFFu;
+}
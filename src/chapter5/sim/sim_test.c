@@ -0,0 +1,818 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include "irq.h"
+#include "system_time.h"
+#include "task_scheduler.h"
+#include "task_coroutine.h"
+#include "ring_buffer.h"
+#include "task_mutex.h"
+#include "task_sem.h"
+#include "soft_timer.h"
+#include "task_flags.h"
+#include "sim.h"
+
+/* Tests run on the host simulation build - each a short scenario, named
+ * on the command line (sim/sim_test churn), with checks at the end. A
+ * scenario either checks outright or adds it's tasks and checks from the
+ * tick once it's time is up. Exits with a failure on the first check that
+ * doesn't hold. make simtest runs them all.
+ */
+
+typedef struct{
+    const char*         name;
+    void                (*start)(void);
+    void                (*tick)(void);
+}test_scenario;
+
+static const test_scenario* scenario;
+
+static void test_check(bool holds, const char* what) {
+    if(!holds) {
+        printf("sim_test: FAIL %s: %s\n", scenario->name, what);
+        exit(EXIT_FAILURE);
+    }
+}
+
+/* Time - the microsecond clock across the wrap of the 32-bit tick count.
+ * At the simulated 16.67 MHz a tick is 16667 cycles, 1000.02 us - after
+ * 2^32 ticks that's 2^32 * 16667 / 16.666666 cycles per microsecond.
+ */
+
+#define TEST_WRAP_US            (4295053367148ull)
+
+static void test_time_start(void) {
+    system_time_advance(0xFFFFFFFFu);
+    system_time_advance(1u);
+
+    test_check(system_time_get() == 0 && system_time_get64() == 0x100000000ull, "tick count wrapped");
+    test_check(system_time_cycles() == 0x100000000ull * SIM_TICK_CYCLES, "cycles at the wrap");
+    test_check(system_time_us() == TEST_WRAP_US, "microseconds at the wrap");
+
+    printf("sim_test: PASS time us=%llu\n", (unsigned long long)system_time_us());
+    exit(EXIT_SUCCESS);
+}
+
+/* Task churn - every millisecond a spawner adds a few one-shot jobs and a
+ * job that waits for flags that never come, and removes the previous
+ * round's waiter mid-wait. Hundreds of tasks come and go through the
+ * descriptor pool - which must end up with none lost and none left behind.
+ */
+
+#define TEST_RUN_MS             (2000u)
+#define TEST_JOBS_PER_ROUND     (4u)
+#define TEST_NEVER              (0x1u)
+
+static task_desc* test_spawner;
+static task_desc* test_waiter;
+static uint32_t jobs_added;
+static uint32_t jobs_run;
+static uint32_t waiters_removed;
+static uint32_t add_failures;
+
+static void test_job(void) {
+    jobs_run++;
+}
+
+static void test_waiter_job(void) {
+    TASK_BEGIN();
+
+    task_wait_flags(TEST_NEVER, TASK_FLAGS_ANY);
+
+    TASK_END();
+}
+
+static task_desc* test_add_job(task_start_fptr start) {
+    task_attr attr = {0};
+    task_desc* job = NULL;
+
+    attr.start = start;
+    attr.priority = TASK_PRIO_DEFAULT;
+
+    if(task_scheduler_add_task_attr(&attr, &job) != SCHEDULER_OKAY) {
+        add_failures++;
+        return NULL;
+    }
+
+    return job;
+}
+
+static void test_spawner_task(void) {
+    uint32_t idx;
+
+    if(test_waiter != NULL) {
+        test_check(task_scheduler_remove_task(test_waiter) == SCHEDULER_OKAY, "waiter removed");
+        waiters_removed++;
+    }
+
+    for(idx = 0; idx < TEST_JOBS_PER_ROUND; idx++) {
+        if(test_add_job(&test_job) != NULL) {
+            jobs_added++;
+        }
+    }
+
+    test_waiter = test_add_job(&test_waiter_job);
+}
+
+/* The checks - run from the SysTick handler once the time is up, so the
+ * tasks are where the scheduler left them between dispatches.
+ */
+static void test_churn_tick(void) {
+    uint32_t in_flight = jobs_added - jobs_run;
+    uint32_t expected = 1u + in_flight + (test_waiter != NULL ? 1u : 0);
+    uint32_t spare = 0;
+    task_attr attr = {0};
+
+    if(system_time_get() < TEST_RUN_MS) {
+        return;
+    }
+
+    test_check(add_failures == 0, "every job added");
+    test_check(jobs_added > 1000u && in_flight <= TEST_JOBS_PER_ROUND, "every job run");
+    test_check(task_scheduler_task_count() == expected, "task count back to the tasks alive");
+
+    // every descriptor not in use is back in the pool
+    attr.start = &test_job;
+    attr.priority = TASK_PRIO_LOWEST;
+    attr.trigger = TEST_NEVER;
+
+    while(task_scheduler_add_task_attr(&attr, NULL) == SCHEDULER_OKAY) {
+        spare++;
+        test_check(spare <= MAX_TASKS, "descriptor pool bounded");
+    }
+
+    test_check(spare == MAX_TASKS - expected, "no descriptor leaked");
+
+    printf("sim_test: PASS churn jobs=%u waiters_removed=%u\n", jobs_added, waiters_removed);
+    exit(EXIT_SUCCESS);
+}
+
+static void test_churn_start(void) {
+    task_attr spawner_attr = {0};
+
+    spawner_attr.start = &test_spawner_task;
+    spawner_attr.duration = 1u;
+    spawner_attr.priority = TASK_PRIO_HIGHEST;
+    task_scheduler_add_task_attr(&spawner_attr, &test_spawner);
+}
+
+/* Dispatch - a task removed by an interrupt taken just as it's being
+ * dispatched: popped off the ready queue, with interrupts about to be
+ * enabled. Every millisecond a spawner adds a one-shot victim, and the
+ * interrupt hook has the tick come while the victim is popped - the tick
+ * removes it. The removal must only mark the victim, which still runs
+ * the once and is then freed the once.
+ */
+
+#define TEST_DISPATCH_ROUNDS    (500u)
+
+static task_desc* dispatch_victim;
+static bool dispatch_armed;
+static bool dispatch_in_window;
+static uint32_t dispatch_removed;
+static uint32_t dispatch_runs;
+
+static void test_victim_job(void) {
+    dispatch_runs++;
+}
+
+static void test_dispatch_spawner(void) {
+    if(dispatch_victim == NULL && dispatch_removed < TEST_DISPATCH_ROUNDS) {
+        dispatch_victim = test_add_job(&test_victim_job);
+        dispatch_armed = (dispatch_victim != NULL);
+    }
+}
+
+/* Interrupts disabled from the scheduler loop, between dispatches, with
+ * the victim ready - it is about to be popped. Make the tick pending.
+ */
+static void test_dispatch_hook(void) {
+    if(dispatch_armed && task_scheduler_current() == NULL &&
+       dispatch_victim->state == TASK_READY) {
+        dispatch_armed = false;
+        dispatch_in_window = true;
+        sim_clock_sleep();
+    }
+}
+
+static void test_dispatch_tick(void) {
+    uint32_t spare = 0;
+    task_attr attr = {0};
+
+    if(dispatch_in_window) {
+        dispatch_in_window = false;
+        test_check(task_scheduler_remove_task(dispatch_victim) == SCHEDULER_OKAY, "victim removed");
+        dispatch_victim = NULL;
+        dispatch_removed++;
+        return;
+    }
+
+    // the last victim runs after the tick that removed it
+    if(dispatch_removed < TEST_DISPATCH_ROUNDS) {
+        return;
+    }
+
+    test_check(add_failures == 0, "every victim added");
+    test_check(dispatch_runs == TEST_DISPATCH_ROUNDS, "a victim removed while dispatched runs the once");
+    test_check(task_scheduler_task_count() == 1u, "task count back to the spawner");
+
+    attr.start = &test_job;
+    attr.priority = TASK_PRIO_LOWEST;
+    attr.trigger = TEST_NEVER;
+
+    while(task_scheduler_add_task_attr(&attr, NULL) == SCHEDULER_OKAY) {
+        spare++;
+        test_check(spare <= MAX_TASKS, "descriptor pool bounded");
+    }
+
+    test_check(spare == MAX_TASKS - 1u, "no descriptor freed twice or leaked");
+
+    printf("sim_test: PASS dispatch removed=%u\n", dispatch_removed);
+    exit(EXIT_SUCCESS);
+}
+
+static void test_dispatch_start(void) {
+    task_attr spawner_attr = {0};
+
+    spawner_attr.start = &test_dispatch_spawner;
+    spawner_attr.duration = 1u;
+    spawner_attr.priority = TASK_PRIO_HIGHEST;
+    task_scheduler_add_task_attr(&spawner_attr, NULL);
+
+    sim_irq_set_disable_hook(&test_dispatch_hook);
+}
+
+/* EDF - the admission control and the order of dispatch. A task is only
+ * admitted while the utilization (or density, with a deadline shorter than
+ * the duration) of the set stays within 100%. Of two tasks released at
+ * once, the one with the earlier deadline runs first whatever it's priority.
+ */
+
+#define TEST_EDF_DURATION       (100u)
+#define TEST_EDF_RUNS           (10u)
+
+static char edf_order[2u * TEST_EDF_RUNS + 1u];
+static uint32_t edf_runs;
+
+static void test_edf_early(void) {
+    if(edf_runs < 2u * TEST_EDF_RUNS) {
+        edf_order[edf_runs++] = 'e';
+    }
+}
+
+static void test_edf_late(void) {
+    if(edf_runs < 2u * TEST_EDF_RUNS) {
+        edf_order[edf_runs++] = 'l';
+    }
+}
+
+static task_scheduler_err test_add_timed(task_start_fptr start, systime_t duration, systime_t deadline,
+                                         systime_t wcet, uint8_t priority, task_desc** handle) {
+    task_attr attr = {0};
+
+    attr.start = start;
+    attr.duration = duration;
+    attr.deadline = deadline;
+    attr.wcet = wcet;
+    attr.priority = priority;
+
+    return task_scheduler_add_task_attr(&attr, handle);
+}
+
+static void test_edf_tick(void) {
+    uint32_t idx;
+
+    if(edf_runs < 2u * TEST_EDF_RUNS) {
+        return;
+    }
+
+    for(idx = 0; idx < TEST_EDF_RUNS; idx++) {
+        test_check(edf_order[2u * idx] == 'e' && edf_order[2u * idx + 1u] == 'l', "earlier deadline first");
+    }
+
+    test_check(task_scheduler_total_misses() == 0, "no deadline missed");
+
+    printf("sim_test: PASS edf order=%s\n", edf_order);
+    exit(EXIT_SUCCESS);
+}
+
+static void test_edf_start(void) {
+    task_desc* half;
+
+    task_scheduler_set_policy(SCHEDULER_POLICY_EDF);
+
+    test_check(test_add_timed(&test_job, 10u, 0, 11u, TASK_PRIO_DEFAULT, NULL) == SCHEDULER_UTILIZATION_EXCEEDED,
+               "wcet past the duration rejected");
+    test_check(test_add_timed(&test_job, 10u, 0, 5u, TASK_PRIO_DEFAULT, &half) == SCHEDULER_OKAY, "half admitted");
+    test_check(task_scheduler_utilization() == TASK_UTIL_FULL / 2u, "half counted");
+
+    // the density over the deadline counts, not the utilization over the duration
+    test_check(test_add_timed(&test_job, 1000u, 8u, 5u, TASK_PRIO_DEFAULT, NULL) == SCHEDULER_UTILIZATION_EXCEEDED,
+               "density past full rejected");
+    test_check(task_scheduler_utilization() == TASK_UTIL_FULL / 2u, "rejected task not counted");
+
+    // scaled down to 32 bits - rounded up, never under-estimated, within 0.1%
+    test_check(test_add_timed(&test_job, 0x7FFFFFFEu, 0, 0x2AAAAAAAu, TASK_PRIO_DEFAULT, NULL) == SCHEDULER_OKAY,
+               "long duration admitted");
+    test_check(task_scheduler_utilization() > TASK_UTIL_FULL / 2u + TASK_UTIL_FULL / 3u &&
+               task_scheduler_utilization() <= TASK_UTIL_FULL / 2u + TASK_UTIL_FULL / 3u + 1000u, "a third rounded up");
+
+    test_check(test_add_timed(&test_job, 6u, 0, 1u, TASK_PRIO_DEFAULT, NULL) == SCHEDULER_UTILIZATION_EXCEEDED,
+               "a sixth past full rejected");
+
+    test_check(task_scheduler_remove_task(half) == SCHEDULER_OKAY, "half removed");
+    test_check(task_scheduler_utilization() <= TASK_UTIL_FULL / 3u + 1000u, "half given back");
+
+    // released together every duration - the later deadline at the higher priority
+    test_check(test_add_timed(&test_edf_late, TEST_EDF_DURATION, 50u, 10u, TASK_PRIO_HIGHEST, NULL) == SCHEDULER_OKAY,
+               "late admitted");
+    test_check(test_add_timed(&test_edf_early, TEST_EDF_DURATION, 20u, 5u, TASK_PRIO_LOWEST, NULL) == SCHEDULER_OKAY,
+               "early admitted");
+}
+
+/* Ring buffer - elements of an odd size through a buffer that wraps over
+ * and over, in runs of every length up to the capacity, with the head and
+ * tail counts also wrapping past 2^32. What comes out is what went in,
+ * in order, and the buffer is never over- or under-filled.
+ */
+
+#define TEST_RING_CAPACITY      (8u)
+#define TEST_RING_ROUNDS        (1000u)
+
+typedef struct{
+    uint8_t             bytes[3];
+}test_ring_elem;
+
+static void test_ring_start(void) {
+    test_ring_elem storage[TEST_RING_CAPACITY];
+    test_ring_elem in[TEST_RING_CAPACITY + 1u];
+    test_ring_elem out[TEST_RING_CAPACITY + 1u];
+    ring_buffer ring;
+    uint32_t pushed = 0;
+    uint32_t popped = 0;
+    uint32_t round, idx, len, count;
+
+    test_check(!ring_buffer_init(&ring, storage, 6u, sizeof(test_ring_elem)), "capacity not a power of two");
+    test_check(ring_buffer_init(&ring, storage, TEST_RING_CAPACITY, sizeof(test_ring_elem)), "capacity a power of two");
+
+    // the free-running counts a little short of wrapping
+    ring.head = 0xFFFFFFF0u;
+    ring.tail = 0xFFFFFFF0u;
+
+    for(round = 0; round < TEST_RING_ROUNDS; round++) {
+        len = round % (TEST_RING_CAPACITY + 2u);
+
+        for(idx = 0; idx < len; idx++) {
+            in[idx].bytes[0] = (uint8_t)(pushed + idx);
+            in[idx].bytes[1] = (uint8_t)((pushed + idx) >> 8);
+            in[idx].bytes[2] = 0xA5u;
+        }
+
+        count = ring_buffer_write(&ring, in, len);
+        test_check(count <= len && ring_buffer_count(&ring) <= TEST_RING_CAPACITY, "never over-filled");
+        test_check(count == len || ring_buffer_space(&ring) == 0, "written up to full");
+        pushed += count;
+
+        // read back a little less than was written every other round
+        count = ring_buffer_read(&ring, out, (round & 1u) ? len : len / 2u);
+        for(idx = 0; idx < count; idx++) {
+            test_check(out[idx].bytes[0] == (uint8_t)(popped + idx) &&
+                       out[idx].bytes[1] == (uint8_t)((popped + idx) >> 8) &&
+                       out[idx].bytes[2] == 0xA5u, "read in the order written");
+        }
+        popped += count;
+
+        test_check(ring_buffer_count(&ring) == pushed - popped, "count the elements in flight");
+        test_check(ring_buffer_space(&ring) == TEST_RING_CAPACITY - (pushed - popped), "space the rest");
+    }
+
+    while(ring_buffer_pop(&ring, &out[0])) {
+        test_check(out[0].bytes[0] == (uint8_t)popped && out[0].bytes[1] == (uint8_t)(popped >> 8),
+                   "popped in the order written");
+        popped++;
+    }
+
+    test_check(pushed == popped && ring_buffer_count(&ring) == 0, "emptied");
+    test_check(ring.head < 0xFFFFFFF0u, "counts wrapped");
+
+    printf("sim_test: PASS ring elements=%u\n", pushed);
+    exit(EXIT_SUCCESS);
+}
+
+/* Mutex - priority inheritance, and it's undo on unlock. A low priority
+ * task locks the mutex, starts a high priority task and sleeps holding it.
+ * The high priority task waits on the mutex, so the low one inherits it's
+ * priority - and when it wakes along with a medium priority task, it runs
+ * first. It's unlock hands the mutex to the high priority task and drops
+ * it back to it's own priority, ahead of the medium one running.
+ */
+
+#define TEST_MUTEX_LOW          (20u)
+#define TEST_MUTEX_MEDIUM       (10u)
+#define TEST_MUTEX_HIGH         (5u)
+#define TEST_MUTEX_WAKE         (10u)
+#define TEST_MUTEX_RUN_MS       (20u)
+
+static task_mutex test_mutex = TASK_MUTEX_INIT;
+static char mutex_order[8];
+static uint32_t mutex_steps;
+static uint8_t mutex_held_priority;
+static uint8_t mutex_unlocked_priority;
+static bool mutex_handed;
+
+static void test_mutex_step(char step) {
+    if(mutex_steps < sizeof(mutex_order) - 1u) {
+        mutex_order[mutex_steps++] = step;
+    }
+}
+
+static void test_mutex_high(void) {
+    TASK_BEGIN();
+
+    task_lock(&test_mutex);
+    mutex_handed = (test_mutex.owner & ~TASK_MUTEX_CONTENDED) == (uint32_t)task_scheduler_current();
+    test_mutex_step('H');
+    task_mutex_unlock(&test_mutex);
+
+    TASK_END();
+}
+
+static void test_mutex_medium(void) {
+    test_mutex_step('M');
+}
+
+static void test_mutex_low(void) {
+    TASK_BEGIN();
+
+    task_lock(&test_mutex);
+    test_add_timed(&test_mutex_high, 0, 0, 0, TEST_MUTEX_HIGH, NULL);
+    task_sleep_until(TEST_MUTEX_WAKE);
+
+    mutex_held_priority = task_scheduler_current()->priority;
+    test_mutex_step('L');
+    task_mutex_unlock(&test_mutex);
+    mutex_unlocked_priority = task_scheduler_current()->priority;
+
+    TASK_END();
+}
+
+static void test_mutex_tick(void) {
+    task_mutex_stats stats;
+
+    if(system_time_get() < TEST_MUTEX_RUN_MS) {
+        return;
+    }
+
+    task_mutex_get_stats(&test_mutex, &stats);
+
+    test_check(mutex_held_priority == TEST_MUTEX_HIGH, "owner inherits the waiter's priority");
+    test_check(mutex_unlocked_priority == TEST_MUTEX_LOW, "owner back to it's own priority on unlock");
+    test_check(strcmp(mutex_order, "LHM") == 0, "owner runs ahead of the medium priority task");
+    test_check(mutex_handed, "mutex handed to the waiter");
+    test_check(test_mutex.owner == 0 && test_mutex.waiters == NULL, "mutex free");
+    test_check(stats.hold_count == 2u, "both holds counted");
+
+    printf("sim_test: PASS mutex order=%s\n", mutex_order);
+    exit(EXIT_SUCCESS);
+}
+
+static void test_mutex_start(void) {
+    test_add_timed(&test_mutex_low, 0, 0, 0, TEST_MUTEX_LOW, NULL);
+    test_add_timed(&test_mutex_medium, TEST_MUTEX_WAKE, 0, 0, TEST_MUTEX_MEDIUM, NULL);
+}
+
+/* Semaphore - the handoff of a give to a waiter. Two tasks wait on an
+ * empty semaphore, and the tick gives it twice, then once more with no
+ * one waiting. Each give to a waiter goes to the highest priority one and
+ * leaves the count at 0 - so a higher priority task that tries to take
+ * it every tick, and runs first, only ever gets the last give.
+ */
+
+#define TEST_SEM_THIEF          (0u)
+#define TEST_SEM_FIRST          (5u)
+#define TEST_SEM_SECOND         (10u)
+#define TEST_SEM_GIVES_MS       (5u)
+#define TEST_SEM_RUN_MS         (20u)
+
+static task_sem test_sem = TASK_SEM_INIT(0);
+static char sem_order[4];
+static uint32_t sem_takes;
+static uint32_t sem_thefts;
+static systime_t sem_theft_time;
+
+static void test_sem_taker(void) {
+    TASK_BEGIN();
+
+    task_take(&test_sem);
+    test_check(!task_scheduler_current()->granted, "handoff taken");
+    if(sem_takes < sizeof(sem_order) - 1u) {
+        sem_order[sem_takes++] = (task_scheduler_current()->priority == TEST_SEM_FIRST) ? 'F' : 'S';
+    }
+
+    TASK_END();
+}
+
+static void test_sem_thief(void) {
+    if(task_sem_try_take(&test_sem)) {
+        sem_thefts++;
+        sem_theft_time = system_time_get();
+    }
+}
+
+static void test_sem_tick(void) {
+    systime_t now = system_time_get();
+
+    if(now == TEST_SEM_GIVES_MS || now == 2u * TEST_SEM_GIVES_MS || now == 3u * TEST_SEM_GIVES_MS) {
+        task_sem_give(&test_sem);
+        test_check(task_sem_count(&test_sem) == (now == 3u * TEST_SEM_GIVES_MS ? 1u : 0), "given to the waiter, not counted");
+    }
+
+    if(now < TEST_SEM_RUN_MS) {
+        return;
+    }
+
+    test_check(strcmp(sem_order, "FS") == 0, "highest priority waiter first");
+    test_check(sem_thefts == 1u && sem_theft_time == 3u * TEST_SEM_GIVES_MS, "only the give with no waiters taken by the thief");
+    test_check(task_sem_count(&test_sem) == 0 && test_sem.waiters == NULL, "semaphore empty");
+
+    printf("sim_test: PASS sem order=%s\n", sem_order);
+    exit(EXIT_SUCCESS);
+}
+
+static void test_sem_start(void) {
+    test_add_timed(&test_sem_taker, 0, 0, 0, TEST_SEM_SECOND, NULL);
+    test_add_timed(&test_sem_taker, 0, 0, 0, TEST_SEM_FIRST, NULL);
+    test_add_timed(&test_sem_thief, 1u, 0, 0, TEST_SEM_THIEF, NULL);
+}
+
+/* Soft timers - the callbacks run in the order of expiry, each at the tick
+ * it's timer expired on. One-shot timers started out of order, one that
+ * restarts itself from it's callback, one stopped by another's callback
+ * before it expires and a periodic one - which is re-armed a period after
+ * each expiry, whenever it's callback ran.
+ */
+
+#define TEST_TIMER_RUN_MS       (20u)
+#define TEST_TIMER_FIRES        (4u)
+
+typedef struct{
+    soft_timer          timer;
+    systime_t           expected[TEST_TIMER_FIRES];
+    uint32_t            fires;
+}test_timer;
+
+static test_timer timer_late = {{{0}}, {7u, 13u}, 0};
+static test_timer timer_early = {{{0}}, {3u}, 0};
+static test_timer timer_tied = {{{0}}, {3u}, 0};
+static test_timer timer_last = {{{0}}, {12u}, 0};
+static test_timer timer_stopped = {{{0}}, {0}, 0};
+static test_timer timer_periodic = {{{0}}, {2u, 7u, 12u, 17u}, 0};
+static systime_t timer_last_fire;
+static uint32_t timer_fires;
+
+static void test_timer_callback(void* arg) {
+    test_timer* timer = (test_timer*)arg;
+    systime_t now = system_time_get();
+
+    test_check(timer != &timer_stopped, "stopped timer doesn't expire");
+    test_check(timer->fires < TEST_TIMER_FIRES && now == timer->expected[timer->fires], "expired on time");
+    test_check(now >= timer_last_fire, "expired in order");
+
+    timer->fires++;
+    timer_fires++;
+    timer_last_fire = now;
+
+    if(timer == &timer_early) {
+        soft_timer_stop(&timer_stopped.timer);
+    }
+    else if(timer == &timer_late && timer->fires == 1u) {
+        soft_timer_start(&timer_late.timer, 6u, 0);
+    }
+}
+
+static void test_timer_tick(void) {
+    if(system_time_get() < TEST_TIMER_RUN_MS) {
+        return;
+    }
+
+    test_check(timer_late.fires == 2u && timer_early.fires == 1u && timer_tied.fires == 1u &&
+               timer_last.fires == 1u && timer_periodic.fires == 4u, "every expiry run");
+    test_check(!soft_timer_active(&timer_late.timer) && soft_timer_active(&timer_periodic.timer),
+               "one-shot timers done, the periodic one running");
+
+    printf("sim_test: PASS timer fires=%u\n", timer_fires);
+    exit(EXIT_SUCCESS);
+}
+
+static void test_timer_add(test_timer* timer, systime_t delay, systime_t period) {
+    soft_timer_init(&timer->timer, &test_timer_callback, timer);
+    test_check(soft_timer_start(&timer->timer, delay, period), "timer started");
+}
+
+static void test_timer_start(void) {
+    test_timer_add(&timer_last, 12u, 0);
+    test_timer_add(&timer_late, 7u, 0);
+    test_timer_add(&timer_stopped, 10u, 0);
+    test_timer_add(&timer_early, 3u, 0);
+    test_timer_add(&timer_periodic, 2u, 5u);
+    test_timer_add(&timer_tied, 3u, 0);
+
+    test_check(soft_timer_service_start(TASK_PRIO_HIGHEST) == SCHEDULER_OKAY, "timer service started");
+}
+
+/* Jitter - how late each release of a periodic task started, in the
+ * power of two buckets of it's histogram. A higher priority task released
+ * along with it runs first, for a number of ticks that differs from
+ * release to release - the lateness of the periodic task's release.
+ */
+
+#define TEST_JITTER_DURATION    (200u)
+#define TEST_JITTER_RELEASES    (8u)
+
+static const uint32_t jitter_hogs[TEST_JITTER_RELEASES] = {0, 1u, 2u, 3u, 4u, 7u, 8u, 100u};
+static const uint32_t jitter_expected[TASK_JITTER_BUCKETS] = {1u, 1u, 2u, 2u, 1u, 0, 0, 1u};
+static task_desc* jitter_task;
+static uint32_t jitter_hog_runs;
+static uint32_t jitter_runs;
+
+static void test_jitter_hog(void) {
+    if(jitter_hog_runs < TEST_JITTER_RELEASES) {
+        sim_clock_advance(jitter_hogs[jitter_hog_runs++] * SIM_TICK_CYCLES);
+    }
+}
+
+static void test_jitter_job(void) {
+    jitter_runs++;
+}
+
+static void test_jitter_tick(void) {
+    task_jitter jitter;
+    uint32_t idx;
+
+    if(jitter_runs < TEST_JITTER_RELEASES) {
+        return;
+    }
+
+    task_scheduler_get_jitter(jitter_task, &jitter);
+
+    for(idx = 0; idx < TASK_JITTER_BUCKETS; idx++) {
+        test_check(jitter.buckets[idx] == jitter_expected[idx], "release counted in it's bucket");
+    }
+    test_check(jitter.skipped == 0, "no release skipped");
+
+    printf("sim_test: PASS jitter releases=%u\n", jitter_runs);
+    exit(EXIT_SUCCESS);
+}
+
+static void test_jitter_start(void) {
+    test_add_timed(&test_jitter_hog, TEST_JITTER_DURATION, 0, 0, TASK_PRIO_HIGHEST, NULL);
+    test_add_timed(&test_jitter_job, TEST_JITTER_DURATION, 0, 0, TASK_PRIO_LOWEST, &jitter_task);
+}
+
+/* Deadline misses - three periodic tasks that each run past their deadline
+ * every release, one under each miss policy. Logged, each miss is only
+ * counted. Skipped, the release after a miss is dropped. Hooked, the hook
+ * is called for each miss - and as it's called from the work queue, it
+ * can release a task by it's flags.
+ */
+
+#define TEST_MISS_DURATION      (20u)
+#define TEST_MISS_DEADLINE      (2u)
+#define TEST_MISS_RUN_TICKS     (5u)
+#define TEST_MISS_RUN_MS        (200u)
+#define TEST_MISS_HOOKED        (0x1u)
+
+static task_desc* miss_logged;
+static task_desc* miss_skipped;
+static task_desc* miss_hooked;
+static task_desc* miss_counter;
+static uint32_t miss_hook_calls;
+static uint32_t miss_hook_released;
+
+static void test_miss_job(void) {
+    sim_clock_advance(TEST_MISS_RUN_TICKS * SIM_TICK_CYCLES);
+}
+
+static void test_miss_hook(task_desc* task) {
+    test_check(task == miss_hooked && task->misses > miss_hook_calls, "hook called for the task that missed");
+    miss_hook_calls++;
+    task_flags_set(miss_counter, TEST_MISS_HOOKED);
+}
+
+static void test_miss_count(void) {
+    miss_hook_released += (task_flags_take(TEST_MISS_HOOKED) != 0) ? 1u : 0;
+}
+
+static task_desc* test_miss_add(uint8_t miss_policy) {
+    task_attr attr = {0};
+    task_desc* task = NULL;
+
+    attr.start = &test_miss_job;
+    attr.duration = TEST_MISS_DURATION;
+    attr.deadline = TEST_MISS_DEADLINE;
+    attr.priority = TASK_PRIO_DEFAULT;
+    attr.miss_policy = miss_policy;
+    attr.miss_hook = &test_miss_hook;
+
+    test_check(task_scheduler_add_task_attr(&attr, &task) == SCHEDULER_OKAY, "task added");
+    return task;
+}
+
+static void test_miss_tick(void) {
+    task_stats stats;
+    task_jitter jitter;
+    uint32_t releases = TEST_MISS_RUN_MS / TEST_MISS_DURATION - 1u;
+
+    if(system_time_get() < TEST_MISS_RUN_MS) {
+        return;
+    }
+
+    task_scheduler_get_stats(miss_logged, &stats);
+    test_check(stats.run_count == releases && task_scheduler_deadline_misses(miss_logged) == releases,
+               "logged - every release run and missed");
+
+    // every other release dropped - the one after each miss
+    task_scheduler_get_stats(miss_skipped, &stats);
+    task_scheduler_get_jitter(miss_skipped, &jitter);
+    test_check(stats.run_count == (releases + 1u) / 2u && task_scheduler_deadline_misses(miss_skipped) == stats.run_count,
+               "skipped - every other release run and missed");
+    test_check(jitter.skipped == stats.run_count, "skipped - the release after each miss dropped");
+
+    test_check(miss_hook_calls == task_scheduler_deadline_misses(miss_hooked) && miss_hook_calls == releases,
+               "hooked - the hook called for every miss");
+    test_check(miss_hook_released == releases, "hooked - a task released from the hook");
+
+    test_check(task_scheduler_total_misses() == 2u * releases + (releases + 1u) / 2u, "every miss counted");
+
+    printf("sim_test: PASS miss misses=%u\n", task_scheduler_total_misses());
+    exit(EXIT_SUCCESS);
+}
+
+static void test_miss_start(void) {
+    task_attr attr = {0};
+
+    miss_logged = test_miss_add(TASK_MISS_LOG);
+    miss_skipped = test_miss_add(TASK_MISS_SKIP_NEXT);
+    miss_hooked = test_miss_add(TASK_MISS_HOOK);
+
+    attr.start = &test_miss_count;
+    attr.priority = TASK_PRIO_HIGHEST;
+    attr.trigger = TEST_MISS_HOOKED;
+    task_scheduler_add_task_attr(&attr, &miss_counter);
+}
+
+static const test_scenario scenarios[] = {
+    {"time",    &test_time_start,   NULL},
+    {"churn",   &test_churn_start,  &test_churn_tick},
+    {"dispatch", &test_dispatch_start, &test_dispatch_tick},
+    {"edf",     &test_edf_start,    &test_edf_tick},
+    {"ring",    &test_ring_start,   NULL},
+    {"mutex",   &test_mutex_start,  &test_mutex_tick},
+    {"sem",     &test_sem_start,    &test_sem_tick},
+    {"timer",   &test_timer_start,  &test_timer_tick},
+    {"jitter",  &test_jitter_start, &test_jitter_tick},
+    {"miss",    &test_miss_start,   &test_miss_tick},
+};
+
+#define TEST_SCENARIOS          (sizeof(scenarios) / sizeof(scenarios[0]))
+
+/* The tick of the scenario being run - it checks once it's time is up */
+void sim_tick(void) {
+    if(scenario->tick != NULL) {
+        scenario->tick();
+    }
+}
+
+int main(int argc, char* argv[]) {
+    uint32_t idx;
+
+    if(!sim_static_below_4g()) {
+        fputs("sim_test: static data above 4 GiB - link with -no-pie\n", stderr);
+        return EXIT_FAILURE;
+    }
+
+    for(idx = 0; argc == 2 && idx < TEST_SCENARIOS; idx++) {
+        if(strcmp(argv[1], scenarios[idx].name) == 0) {
+            scenario = &scenarios[idx];
+        }
+    }
+
+    if(scenario == NULL) {
+        fputs("usage: sim_test <scenario>, one of:", stderr);
+        for(idx = 0; idx < TEST_SCENARIOS; idx++) {
+            fprintf(stderr, " %s", scenarios[idx].name);
+        }
+        fputc('\n', stderr);
+        return EXIT_FAILURE;
+    }
+
+    sim_console_quiet(true);
+    scenario->start();
+
+    irq_master_enable();
+    task_scheduler_run();
+
+    return EXIT_SUCCESS;
+}
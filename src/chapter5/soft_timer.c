@@ -0,0 +1,160 @@
+#include <stdio.h>
+#include "irq.h"
+#include "system_time.h"
+#include "min_heap.h"
+#include "task_scheduler.h"
+#include "task_coroutine.h"
+#include "soft_timer.h"
+
+#define SOFT_TIMER_KICK     (0x1u)  // daemon flag - the earliest expiry changed
+
+/* The running timers, earliest expiry first - shared with interrupt
+ * handlers, so only accessed with interrupts disabled.
+ */
+static heap_node* timer_nodes[SOFT_TIMER_MAX];
+static min_heap timer_heap = {timer_nodes, 0, SOFT_TIMER_MAX};
+static task_desc* volatile timer_daemon = NULL;
+
+/* Initialize a timer - it is stopped until started */
+void soft_timer_init(soft_timer* timer, soft_timer_fptr callback, void* arg) {
+    timer->node.idx = HEAP_NOT_QUEUED;
+    timer->callback = callback;
+    timer->arg = arg;
+    timer->period = 0;
+}
+
+/* (Re)start a timer to expire delay from now, and every period after
+ * that (0 - only once) - from a task, a timer callback or an interrupt
+ * handler. A running timer is restarted. Returns false if SOFT_TIMER_MAX
+ * timers are already running.
+ */
+bool soft_timer_start(soft_timer* timer, systime_t delay, systime_t period) {
+    bool started;
+    bool earliest;
+
+    irq_master_disable();
+
+    min_heap_remove(&timer_heap, &timer->node);
+    timer->period = period;
+    started = min_heap_insert(&timer_heap, &timer->node, system_time_get() + delay);
+    earliest = started && (min_heap_peek(&timer_heap) == &timer->node);
+
+    irq_master_enable();
+
+    // the daemon sleeps till the previous earliest expiry - wake it to re-arm
+    if(earliest && timer_daemon != NULL) {
+        task_flags_set(timer_daemon, SOFT_TIMER_KICK);
+    }
+
+    return started;
+}
+
+/* Stop a timer - from a task, a timer callback or an interrupt handler.
+ * The daemon isn't woken - at worst it wakes up once for nothing.
+ * A callback already under way runs to completion.
+ */
+void soft_timer_stop(soft_timer* timer) {
+    irq_master_disable();
+    min_heap_remove(&timer_heap, &timer->node);
+    irq_master_enable();
+}
+
+/* Whether a timer is running - that is, yet to expire */
+bool soft_timer_active(const soft_timer* timer) {
+    return min_heap_queued(&timer->node);
+}
+
+/* Run the callbacks of all the timers that have expired by now.
+ * A periodic timer is re-armed before it's callback runs - so the
+ * callback may stop or restart it. Interrupts are only disabled
+ * while the heap is being updated - never across a callback.
+ */
+static void soft_timer_expire(void) {
+    systime_t now = system_time_get();
+    heap_node* node;
+
+    irq_master_disable();
+
+    while((node = min_heap_peek(&timer_heap)) != NULL && !systime_after(node->key, now)) {
+        soft_timer* timer = HEAP_ENTRY(node, soft_timer, node);
+        soft_timer_fptr callback = timer->callback;
+        void* arg = timer->arg;
+
+        min_heap_pop(&timer_heap);
+
+        if(timer->period != 0) {
+            min_heap_insert(&timer_heap, node, node->key + timer->period);
+        }
+
+        irq_master_enable();
+        callback(arg);
+        irq_master_disable();
+    }
+
+    irq_master_enable();
+}
+
+/* The timer daemon - a coroutine task that runs the expired timers' callbacks,
+ * then sleeps until the next expiry or until a timer started meanwhile
+ * expires earlier. It is the only task that needs waking for any number of
+ * timers - and no tick is taken in between with tickless idle.
+ */
+static void soft_timer_daemon(void) {
+    heap_node* next;
+    systime_t next_key = 0;
+
+    TASK_BEGIN();
+
+    while(1) {
+        task_flags_take(SOFT_TIMER_KICK);
+        soft_timer_expire();
+
+        irq_master_disable();
+        next = min_heap_peek(&timer_heap);
+
+        if(next != NULL) {
+            next_key = next->key;
+        }
+
+        irq_master_enable();
+
+        // a kick since the flags were taken is caught by the wait itself
+        if(next == NULL) {
+            task_wait_flags(SOFT_TIMER_KICK, TASK_FLAGS_ANY);
+        }
+        else {
+            task_wait_flags_until(SOFT_TIMER_KICK, TASK_FLAGS_ANY, next_key);
+        }
+    }
+
+    TASK_END();
+}
+
+/* Add the timer daemon task at the given priority - the callbacks run at it.
+ * Timers may be started before - they expire once the daemon runs.
+ */
+task_scheduler_err soft_timer_service_start(uint8_t priority) {
+    task_attr attr = {0};
+    task_desc* daemon;
+    task_scheduler_err err;
+
+    if(timer_daemon != NULL) {
+        return SCHEDULER_OKAY;
+    }
+
+    // released by it's kick flag only - and never returns to dormant
+    attr.start = &soft_timer_daemon;
+    attr.priority = priority;
+    attr.trigger = SOFT_TIMER_KICK;
+
+    err = task_scheduler_add_task_attr(&attr, &daemon);
+
+    if(err != SCHEDULER_OKAY) {
+        return err;
+    }
+
+    timer_daemon = daemon;
+    task_flags_set(daemon, SOFT_TIMER_KICK);
+
+    return SCHEDULER_OKAY;
+}
@@ -0,0 +1,35 @@
+#ifndef __SOFT_TIMER_H__
+#define __SOFT_TIMER_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "system_time.h"
+#include "min_heap.h"
+#include "task_scheduler.h"
+
+#define SOFT_TIMER_MAX      (64u)   // timers running at the same time
+
+typedef void (*soft_timer_fptr)(void* arg);
+
+/* A software timer - any number of them share the one SysTick timebase.
+ * Running timers are queued in a min-heap by their expiry time, so
+ * starting, stopping and expiring a timer is O(log n) and nothing is
+ * ever scanned. The callbacks are run by the timer daemon task - not in
+ * an interrupt handler - in the order of expiry.
+ * A period of 0 makes a one-shot timer - otherwise the timer is re-armed
+ * a period after each expiry (not after the callback ran), so it doesn't drift.
+ */
+typedef struct{
+    heap_node           node;
+    soft_timer_fptr     callback;
+    void*               arg;
+    systime_t           period;
+}soft_timer;
+
+void soft_timer_init(soft_timer* timer, soft_timer_fptr callback, void* arg);
+bool soft_timer_start(soft_timer* timer, systime_t delay, systime_t period);
+void soft_timer_stop(soft_timer* timer);
+bool soft_timer_active(const soft_timer* timer);
+task_scheduler_err soft_timer_service_start(uint8_t priority);
+
+#endif /* __SOFT_TIMER_H__ */
@@ -0,0 +1,71 @@
+#include <stdio.h>
+#include <stdint.h>
+#include "stack_check.h"
+
+// words below the stack pointer left unpainted - more than the painting's own frame
+#define STACK_CHECK_PAINT_MARGIN    (32u)
+
+/* Linker symbols bounding the main stack - see lm3s6965_layout.ld */
+extern uint32_t _sram_task_stacks_end;
+extern uint32_t _sram_stacktop;
+
+/* Fill the words from bottom up to (not including) top with the pattern */
+void stack_check_paint(uint32_t* bottom, uint32_t* top)
+{
+    while(bottom < top)
+    {
+        *bottom++ = STACK_PAINT_PATTERN;
+    }
+}
+
+/* The number of words at the bottom of a painted stack that have never
+ * been written to - the stack's headroom.
+ */
+uint32_t stack_check_unused(const uint32_t* bottom, const uint32_t* top)
+{
+    const uint32_t* word = bottom;
+
+    while(word < top && *word == STACK_PAINT_PATTERN)
+    {
+        word++;
+    }
+
+    return (uint32_t)(word - bottom);
+}
+
+/* Paint the part of the main stack that isn't in use yet - everything below
+ * the current stack pointer, but for a margin left for the frame of the
+ * painting itself (stack_check_paint() saves it's return address there).
+ * The margin is counted as used. To be called as early as possible after reset.
+ */
+void stack_check_paint_main(void)
+{
+    uint32_t* sp;
+
+#ifdef SIM_HOST
+    // the host simulation build has no main stack of it's own
+    sp = &_sram_task_stacks_end;
+#else
+    __asm__ __volatile__ ("mrs %0, msp" : "=r" (sp));
+#endif
+
+    if(sp > &_sram_task_stacks_end + STACK_CHECK_PAINT_MARGIN)
+    {
+        stack_check_paint(&_sram_task_stacks_end, sp - STACK_CHECK_PAINT_MARGIN);
+    }
+}
+
+/* The size of the main stack in bytes */
+uint32_t stack_check_main_size(void)
+{
+    return (uint32_t)((uint8_t*)&_sram_stacktop - (uint8_t*)&_sram_task_stacks_end);
+}
+
+/* The most of the main stack ever used, in bytes - in the cooperative mode
+ * this includes the tasks, in the preemptive mode only the handlers.
+ */
+uint32_t stack_check_main_used(void)
+{
+    return stack_check_main_size() -
+           stack_check_unused(&_sram_task_stacks_end, &_sram_stacktop) * sizeof(uint32_t);
+}
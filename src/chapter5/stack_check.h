@@ -0,0 +1,19 @@
+#ifndef __STACK_CHECK_H__
+#define __STACK_CHECK_H__
+
+#include <stdint.h>
+
+/* Stack painting - a stack is filled with a known pattern before it's
+ * used, and the high-water mark is found later by scanning up from the
+ * bottom for the first word the pattern no longer survives in. Stacks
+ * grow down on the Cortex-M3, so the bottom is the lowest address.
+ */
+#define STACK_PAINT_PATTERN     0xCDCDCDCDu
+
+void stack_check_paint(uint32_t* bottom, uint32_t* top);
+uint32_t stack_check_unused(const uint32_t* bottom, const uint32_t* top);
+void stack_check_paint_main(void);
+uint32_t stack_check_main_size(void);
+uint32_t stack_check_main_used(void);
+
+#endif /* __STACK_CHECK_H__ */
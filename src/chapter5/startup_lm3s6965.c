@@ -1,6 +1,18 @@
 #include <stdint.h>
 #include "irq.h"
 
+#ifdef BENCH
+#include "lm3s6965_memmap.h"
+#include "systick.h"
+
+/* The SysTick registers - for the benchmark image to time the startup,
+ * before the .data the driver's register pointer is in is copied.
+ */
+#define BENCH_STCTRL            ((volatile uint32_t*)((M3_PERIPHERAL_BASE) + 0x00000010u))
+#define BENCH_STRELOAD          ((volatile uint32_t*)((M3_PERIPHERAL_BASE) + 0x00000014u))
+#define BENCH_STCURRENT         ((volatile uint32_t*)((M3_PERIPHERAL_BASE) + 0x00000018u))
+#endif
+
 /* Linker symbols for TI Stellaris LM3S6965 
  * defining start/end of various sections
  * using long as ANSI C guarentees long to be at least 4 bytes (32-bits))
@@ -15,6 +27,10 @@ extern uint32_t _sram_stacktop;
 extern void main(void);
 extern void uart0_irq_handler(void);
 extern void _SysTick_Handler(void);
+extern void gptm0_irq_handler(void);
+extern void gptm1_irq_handler(void);
+extern void gptm2_irq_handler(void);
+extern void gptm3_irq_handler(void);
 
 /* This is an unused handler that simply loops infinitely
  * using the __attribute__ ((weak, alias("function_name")))
@@ -80,11 +96,11 @@ void (* const  _exceptions[])(void) = {
     dflt_irq_handler,                                       // 32: ADC0 Sequence 2
     dflt_irq_handler,                                       // 33: ADC0 Sequence 3
     dflt_irq_handler,                                       // 34: Watchdog Timer 0
-    dflt_irq_handler,                                       // 35: Timer 0A
+    gptm0_irq_handler,                                      // 35: Timer 0A
     dflt_irq_handler,                                       // 36: Timer 0B
-    dflt_irq_handler,                                       // 37: Timer 1A
+    gptm1_irq_handler,                                      // 37: Timer 1A
     dflt_irq_handler,                                       // 38: Timer 1B
-    dflt_irq_handler,                                       // 39: Timer 2A
+    gptm2_irq_handler,                                      // 39: Timer 2A
     dflt_irq_handler,                                       // 40: Timer 2B
     dflt_irq_handler,                                       // 41: Analog Comparator 0
     dflt_irq_handler,                                       // 42: Analog Comparator 1
@@ -96,7 +112,7 @@ void (* const  _exceptions[])(void) = {
     0,                                                      // 48: Reserved
     dflt_irq_handler,                                       // 49: UART2
     0,                                                      // 48: Reserved
-    dflt_irq_handler,                                       // 51: Timer 3A
+    gptm3_irq_handler,                                      // 51: Timer 3A
     dflt_irq_handler,                                       // 52: Timer 3B
     dflt_irq_handler,                                       // 53: I2C1
     dflt_irq_handler,                                       // 54: QEI1
@@ -119,6 +135,13 @@ void _Reset_Handler(void)
     /* Let's disable interrupts for now, shall we */
     irq_master_disable();
 
+#ifdef BENCH
+    /* Let the SysTick count down from it's maximum from here to main() */
+    *BENCH_STRELOAD = STRELOAD_MASK;
+    *BENCH_STCURRENT = 0;
+    *BENCH_STCTRL = STCTRL_CLKSRC | STCTRL_ENABLE;
+#endif
+
     /* Copy the data segment from flash to sram */
 
     uint32_t *pSrc = &_flash_sdata;   
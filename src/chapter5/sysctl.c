@@ -334,6 +334,18 @@ void sysctl_periph_clk_enable(uint32_t periph)
         case UART2_BASE:
             sysctl->RCGC1 |= SYSCTL_RCGC1_UART2;
             break;
+        case TIMER0_BASE:
+            sysctl->RCGC1 |= SYSCTL_RCGC1_TIMER0;
+            break;
+        case TIMER1_BASE:
+            sysctl->RCGC1 |= SYSCTL_RCGC1_TIMER1;
+            break;
+        case TIMER2_BASE:
+            sysctl->RCGC1 |= SYSCTL_RCGC1_TIMER2;
+            break;
+        case TIMER3_BASE:
+            sysctl->RCGC1 |= SYSCTL_RCGC1_TIMER3;
+            break;
         default:
             break;
     }
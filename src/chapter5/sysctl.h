@@ -164,6 +164,10 @@
 #define SYSCTL_RCGC1_UART0              0x00000001u
 #define SYSCTL_RCGC1_UART1              0x00000002u
 #define SYSCTL_RCGC1_UART2              0x00000003u
+#define SYSCTL_RCGC1_TIMER0             0x00010000u
+#define SYSCTL_RCGC1_TIMER1             0x00020000u
+#define SYSCTL_RCGC1_TIMER2             0x00040000u
+#define SYSCTL_RCGC1_TIMER3             0x00080000u
 
 void sysctl_setclk(uint32_t cfg_rcc, uint32_t cfg_rcc2);
 uint32_t sysctl_getclk(void);
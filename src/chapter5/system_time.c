@@ -1,15 +1,23 @@
+#include "systick.h"
+#include "cycle_counter.h"
 #include "system_time.h"
 
 /* To keep track of the time across
- * our system since startup.
+ * our system since startup - the 32-bit tick count and the number of
+ * times it has wrapped, the upper half of the 64-bit count.
  */
 static volatile systime_t system_time;
+static volatile uint32_t system_time_wraps;
 
 /* Increment the system time as and when the 
  * predefined SysTick period set in the init elapses.
  */
 void system_time_incr(void){
     system_time++;
+
+    if(system_time == 0) {
+        system_time_wraps++;
+    }
     return;
 }
 
@@ -18,3 +26,106 @@ void system_time_incr(void){
 systime_t system_time_get(void){
     return system_time;
 }
+
+/* Advance the system time by the ticks that elapsed
+ * while the SysTick interrupt was suppressed (tickless idle).
+ */
+void system_time_advance(systime_t ticks){
+    systime_t before = system_time;
+
+    system_time += ticks;
+
+    if(system_time < before) {
+        system_time_wraps++;
+    }
+    return;
+}
+
+/* The system time as a 64-bit tick count - consistent without masking the
+ * interrupts: the upper half is read on either side of the lower half, and
+ * if the tick wrapped the lower half in between, we read again. That holds
+ * from anything the SysTick handler can't be preempted by - at the default
+ * priorities, every task and interrupt handler.
+ */
+uint64_t system_time_get64(void){
+    uint32_t wraps;
+    systime_t ticks;
+
+    do {
+        wraps = system_time_wraps;
+        ticks = system_time;
+    }while(wraps != system_time_wraps);
+
+    return ((uint64_t)wraps << 32) | ticks;
+}
+
+/* The 64-bit tick count and the cycles elapsed into the current tick -
+ * off the SysTick counter. The tick count is read on either side of the
+ * counter to make sure the two belong to the same period. With the SysTick
+ * interrupt held off, the counter may have wrapped with the period not yet
+ * accounted for - hence the check for a pending interrupt.
+ */
+static uint64_t system_time_sample(uint32_t* elapsed){
+    uint32_t period = systick_get_period();
+    uint64_t ticks;
+    uint32_t current;
+
+    do {
+        ticks = system_time_get64();
+        current = systick_get_current();
+    }while(ticks != system_time_get64());
+
+    if(systick_irq_pending() && current > (period / 2u)) {
+        ticks++;
+    }
+
+    *elapsed = period - 1u - current;
+    return ticks;
+}
+
+/* The time since startup in cycles of the system clock */
+uint64_t system_time_cycles(void){
+    uint32_t elapsed;
+    uint64_t ticks = system_time_sample(&elapsed);
+
+    return ticks * systick_get_period() + elapsed;
+}
+
+/* x / divisor, and the remainder - 4 bits at a time, so each step is a
+ * 32-bit division as long as the divisor is below 2^28 (268 MHz). We
+ * don't link against libgcc for a 64-bit one.
+ */
+static uint64_t system_time_div(uint64_t x, uint32_t divisor, uint32_t* rem){
+    uint64_t quot = 0;
+    uint32_t part = 0;
+    int32_t shift;
+
+    for(shift = 60; shift >= 0; shift -= 4) {
+        part = (part << 4) | (uint32_t)((x >> shift) & 0xFu);
+        quot = (quot << 4) | (part / divisor);
+        part %= divisor;
+    }
+
+    *rem = part;
+    return quot;
+}
+
+/* The time since startup in microseconds - exactly the cycles since
+ * startup scaled by the clock rate, with no error that builds up over the
+ * ticks. Whole seconds, then the cycles left over a decimal digit at a time.
+ */
+uint64_t system_time_us(void){
+    uint32_t hz = cycle_counter_hz();
+    uint32_t rem;
+    uint32_t usecs = 0;
+    uint32_t digit;
+    uint64_t secs = system_time_div(system_time_cycles(), hz, &rem);
+
+    for(digit = 0; digit < 6u; digit++) {
+        rem *= 10u;
+        usecs = usecs * 10u + rem / hz;
+        rem %= hz;
+    }
+
+    return secs * 1000000u + usecs;
+}
@@ -1,7 +1,38 @@
+#ifndef __SYSTEM_TIME_H__
+#define __SYSTEM_TIME_H__
+
 #include <stdint.h>
+#include <stdbool.h>
 
+/* The system time in SysTick periods (ticks) - 32 bits, so at a 1 ms tick
+ * it wraps after about 49.7 days. Compare points in systime_t only with
+ * the wrap-safe helpers below - never with < or > directly.
+ */
 typedef uint32_t systime_t;
 
 void system_time_incr(void);
 systime_t system_time_get(void);
+void system_time_advance(systime_t ticks);
+
+/* The 64-bit monotonic clock - the time since startup in ticks, cycles
+ * and microseconds. None of these wrap within the life of a node.
+ */
+uint64_t system_time_get64(void);
+uint64_t system_time_cycles(void);
+uint64_t system_time_us(void);
+
+/* Whether the point a in systime_t is before (after) the point b - wrap-safe,
+ * as long as the two are less than half the range (about 24.8 days at a 1 ms
+ * tick) apart, which any deadline or timeout is.
+ */
+static inline bool systime_before(systime_t a, systime_t b)
+{
+    return (int32_t)(a - b) < 0;
+}
+
+static inline bool systime_after(systime_t a, systime_t b)
+{
+    return (int32_t)(a - b) > 0;
+}
 
+#endif /* __SYSTEM_TIME_H__ */
@@ -1,14 +1,20 @@
 #include <stdint.h>
+#include <stdbool.h>
 #include "lm3s6965_memmap.h"
 #include "sysctl.h"
 #include "systick.h"
 #include "uart_drv.h"
 #include "serial_print.h"
 #include "system_time.h"
+#include "task_scheduler.h"
+#include "trace.h"
 
 #define SYS_TIMER_BASE          ((M3_PERIPHERAL_BASE)+ 0x00000010u)
+#define SCB_INTCTRL_ADDR        ((M3_PERIPHERAL_BASE)+ 0x00000D04u)
+#define INTCTRL_PENDSTSET       0x04000000u
 #define MILLISECS_IN_SEC        1000u
 #define TWENTY_TICKS            20u
+#define SYSTICK_EXCEPTION       15u
 
 /* System Timer SysTcik register map structure.
  * Refer: http://www.ti.com/lit/ds/symlink/lm3s6965.pdf Table 3-7 and Section 3-3
@@ -22,8 +28,20 @@ typedef struct __attribute__((packed)){
 
 static volatile systick_regs *systick = (systick_regs*)SYS_TIMER_BASE;
 
+/* Interrupt Control and State register - for the SysTick pending bit.
+ * Refer: http://www.ti.com/lit/ds/symlink/lm3s6965.pdf Section 3.4 (INTCTRL)
+ */
+typedef struct __attribute__((packed)){
+    uint32_t INTCTRL;           //0xD04 Interrupt Control and State
+}scb_intctrl_regs;
+
+static volatile scb_intctrl_regs *scb_intctrl = (scb_intctrl_regs*)SCB_INTCTRL_ADDR;
+
 static volatile uint32_t tick_count = 0;
 
+// number of system clock cycles in one SysTick period
+static uint32_t tick_period;
+
 
 /* Function to enable the SysTick timer 
  * by setting the ENABLE bit and 
@@ -85,13 +103,111 @@ void systick_set_period_ms(uint32_t millisec)
      */
     uint32_t count = systick_millisec_to_timer_period(millisec);
     systick->STRELOAD = count;
+    tick_period = count + 1u;
+
+    // the counter is only reloaded once it reaches 0 - out of reset it
+    // counts down from anything, so clear it to start a full period
+    systick->STCURRENT = 0;
+}
+
+/* The number of system clock cycles in one SysTick period */
+uint32_t systick_get_period(void)
+{
+    return tick_period;
+}
+
+/* The current value of the SysTick counter - it counts down
+ * from STRELOAD to 0 through each period.
+ */
+uint32_t systick_get_current(void)
+{
+    return systick->STCURRENT & STCURRENT_MASK;
+}
+
+/* Whether the SysTick interrupt is pending - i.e. the counter has
+ * reached 0 but the interrupt is yet to be handled.
+ */
+bool systick_irq_pending(void)
+{
+    return (scb_intctrl->INTCTRL & INTCTRL_PENDSTSET) != 0;
+}
+
+/* Suppress the SysTick interrupts for up to ticks periods and sleep until
+ * either the last of them expires or some other interrupt wakes us up.
+ * To be called with interrupts disabled - so that the wake up interrupt is
+ * only handled once we have accounted for the time slept.
+ * Returns the number of whole periods that elapsed without an interrupt -
+ * the period that expires while asleep is left to the (pending) interrupt.
+ */
+uint32_t systick_sleep_ticks(uint32_t ticks)
+{
+    uint32_t period = tick_period;
+    uint32_t max_ticks = STRELOAD_MASK / period;
+    uint32_t remaining, reload, ctrl, position;
+
+    if(ticks > max_ticks)
+    {
+        ticks = max_ticks;
+    }
+
+    if(ticks < 2u)
+    {
+        return 0;
+    }
+
+    /* Stop the counter - what it holds is what is left of the current period.
+     * Extend this to the end of the last period we are to sleep for.
+     */
+    systick->STCTRL &= ~(STCTRL_ENABLE);
+    remaining = systick->STCURRENT;
+    reload = remaining + (ticks - 1u) * period;
+
+    // writing to STCURRENT clears it, so the new reload value is loaded on enable
+    systick->STRELOAD = reload;
+    systick->STCURRENT = 0;
+    systick->STCTRL |= STCTRL_ENABLE;
+    systick->STRELOAD = period - 1u;
+
+    __asm__ __volatile__ ("dsb\n"
+                          "wfi\n"
+                          "isb\n");
+
+    // reading STCTRL clears the COUNT flag - so read it just the once
+    ctrl = systick->STCTRL;
+    systick->STCTRL = ctrl & ~(STCTRL_ENABLE);
+
+    if(ctrl & STCTRL_COUNT)
+    {
+        /* We slept through to the end - the counter has already restarted
+         * with a full period and it's interrupt is pending.
+         */
+        systick->STCTRL = ctrl | STCTRL_ENABLE;
+        return ticks - 1u;
+    }
+
+    /* Woken up early by some other interrupt. Work out how far into
+     * the sleep we got - measured from the start of the period that was
+     * underway when we went to sleep - and resume counting down from
+     * there so the next interrupt fires on the original schedule.
+     */
+    position = (period - remaining) + (reload - systick->STCURRENT);
+
+    systick->STRELOAD = (period - (position % period)) - 1u;
+    systick->STCURRENT = 0;
+    systick->STCTRL = ctrl | STCTRL_ENABLE;
+    systick->STRELOAD = period - 1u;
+
+    return position / period;
 }
 
-/* The SysTick interrupt handler - currently configured to print 
- * the number of Systick ticks elapsed at the rate of every 20 ticks
+/* The SysTick interrupt handler - advances the system time and
+ * lets the scheduler release the tasks that are now due
  */
 void _SysTick_Handler(void)
 {
+    trace_record(TRACE_ISR_ENTER, SYSTICK_EXCEPTION, 0);
     system_time_incr();
+    task_scheduler_tick();
+    trace_record(TRACE_ISR_EXIT, SYSTICK_EXCEPTION, 0);
 }
 
@@ -1,6 +1,9 @@
 #ifndef __SYSTICK_H__
 #define __SYSTICK_H__
 
+#include <stdint.h>
+#include <stdbool.h>
+
 #define STCTRL_ENABLE           0x00000001u
 #define STCTRL_INTEN            0x00000002u
 #define STCTRL_CLKSRC           0x00000004u
@@ -19,5 +22,9 @@ void systick_disable(void);
 void systick_irq_enable(void);
 void systick_irq_disable(void);
 void systick_set_period_ms(uint32_t millisec);
+uint32_t systick_get_period(void);
+uint32_t systick_get_current(void);
+bool systick_irq_pending(void);
+uint32_t systick_sleep_ticks(uint32_t ticks);
 
 #endif /* __SYSTICK_H__ */
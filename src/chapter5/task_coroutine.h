@@ -0,0 +1,138 @@
+#ifndef __TASK_COROUTINE_H__
+#define __TASK_COROUTINE_H__
+
+#include <stdint.h>
+#include "task_scheduler.h"
+#include "task_event.h"
+#include "task_flags.h"
+#include "msg_queue.h"
+#include "task_mutex.h"
+#include "task_sem.h"
+
+/* Stackless coroutine tasks - in the style of protothreads.
+ *
+ * A task's start function can give up the CPU part way through a release
+ * and pick up where it left off the next time it is dispatched - without a
+ * stack of it's own. All that is kept is the line to resume at, in the
+ * task_desc (2 bytes). The body goes between TASK_BEGIN() and TASK_END():
+ *
+ *   void my_task(void) {
+ *       static systime_t start;
+ *       TASK_BEGIN();
+ *       start = system_time_get();
+ *       task_sleep_until(start + 100u);
+ *       ...
+ *       TASK_END();
+ *   }
+ *
+ * As the function actually returns at each wait, local variables don't
+ * survive across task_yield(), task_sleep_until() and the other waits -
+ * keep what is needed in static (or otherwise task owned) variables.
+ * The waits are implemented with a switch statement, so they can't be
+ * used within another switch statement in the body.
+ */
+
+#define TASK_BEGIN()                                        \
+    uint16_t* task_cr_line__ = task_scheduler_cr_line();    \
+    switch(*task_cr_line__) {                               \
+        case 0:
+
+#define TASK_END()                                          \
+    }                                                       \
+    *task_cr_line__ = 0;                                    \
+    return
+
+/* Finish the current release early - the next dispatch starts from the top */
+#define TASK_EXIT()                                         \
+    do {                                                    \
+        *task_cr_line__ = 0;                                \
+        return;                                             \
+    } while(0)
+
+/* Let the other ready tasks run, then carry on */
+#define task_yield()                                        \
+    do {                                                    \
+        *task_cr_line__ = __LINE__;                         \
+        return;                                             \
+        case __LINE__:;                                     \
+    } while(0)
+
+/* Carry on once the system time reaches t */
+#define task_sleep_until(t)                                 \
+    do {                                                    \
+        *task_cr_line__ = __LINE__;                         \
+        if(task_scheduler_sleep_until(t)) {                 \
+            return;                                         \
+        }                                                   \
+        case __LINE__:;                                     \
+    } while(0)
+
+/* Carry on once the event e (a task_event*) is signalled */
+#define task_wait_event(e)                                  \
+    do {                                                    \
+        *task_cr_line__ = __LINE__;                         \
+        if(task_event_wait(e)) {                            \
+            return;                                         \
+        }                                                   \
+        case __LINE__:;                                     \
+    } while(0)
+
+/* Carry on once any or all (mode) of the current task's flags in mask are set */
+#define task_wait_flags(mask, mode)                         \
+    do {                                                    \
+        *task_cr_line__ = __LINE__;                         \
+        if(task_flags_wait((mask), (mode))) {               \
+            return;                                         \
+        }                                                   \
+        case __LINE__:;                                     \
+    } while(0)
+
+/* As task_wait_flags() - but carry on at time t at the latest */
+#define task_wait_flags_until(mask, mode, t)                \
+    do {                                                    \
+        *task_cr_line__ = __LINE__;                         \
+        if(task_flags_wait_until((mask), (mode), (t))) {    \
+            return;                                         \
+        }                                                   \
+        case __LINE__:;                                     \
+    } while(0)
+
+/* Take the oldest message off the queue q (a msg_queue*) into msg (a void**) -
+ * waiting while the queue is empty. The signal that ends the wait may have
+ * been for a message another task took first - so the queue is checked again.
+ */
+#define task_receive(q, msg)                                \
+    do {                                                    \
+        while(!msg_queue_receive((q), (msg))) {             \
+            task_wait_event(&(q)->not_empty);               \
+        }                                                   \
+    } while(0)
+
+/* Lock the mutex m (a task_mutex*) - waiting while another task holds it.
+ * Unlock it with task_mutex_unlock(), before the task next waits on anything
+ * else if it can - the mutex stays held through the wait.
+ */
+#define task_lock(m)                                        \
+    do {                                                    \
+        *task_cr_line__ = __LINE__;                         \
+        case __LINE__:;                                     \
+        while(!task_mutex_try_lock(m)) {                    \
+            if(task_mutex_wait(m)) {                        \
+                return;                                     \
+            }                                               \
+        }                                                   \
+    } while(0)
+
+/* Take the semaphore s (a task_sem*) - waiting while it's count is 0 */
+#define task_take(s)                                        \
+    do {                                                    \
+        *task_cr_line__ = __LINE__;                         \
+        case __LINE__:;                                     \
+        while(!task_sem_try_take(s)) {                      \
+            if(task_sem_wait(s)) {                          \
+                return;                                     \
+            }                                               \
+        }                                                   \
+    } while(0)
+
+#endif /* __TASK_COROUTINE_H__ */
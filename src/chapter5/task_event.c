@@ -0,0 +1,67 @@
+#include <stdio.h>
+#include <stdbool.h>
+#include "irq.h"
+#include "task_scheduler.h"
+#include "task_event.h"
+
+/* Set up an event with no waiters and no pending signal */
+void task_event_init(task_event* event) {
+    event->waiters = NULL;
+    event->pending = false;
+}
+
+/* Signal the event - from a task or an interrupt handler.
+ * The waiters are woken in the order they started waiting.
+ */
+void task_event_signal(task_event* event) {
+    task_desc* task;
+
+    irq_master_disable();
+
+    task = event->waiters;
+
+    if(task == NULL) {
+        event->pending = true;
+    }
+
+    event->waiters = NULL;
+
+    while(task != NULL) {
+        task_desc* next = task->wait_next;
+
+        task->wait_next = NULL;
+        task->wait_list = NULL;
+        task_scheduler_wake(task);
+        task = next;
+    }
+
+    irq_master_enable();
+}
+
+/* The current task waits for the event. Returns false if the event is
+ * already pending (and consumes it) - otherwise the task is queued as a
+ * waiter and is to return, see task_wait_event() in task_coroutine.h.
+ */
+bool task_event_wait(task_event* event) {
+    task_desc* self = task_scheduler_current();
+    task_desc** tail;
+
+    irq_master_disable();
+
+    if(event->pending) {
+        event->pending = false;
+        irq_master_enable();
+        return false;
+    }
+
+    self->wait_next = NULL;
+    for(tail = &event->waiters; *tail != NULL; tail = &(*tail)->wait_next);
+    *tail = self;
+    self->wait_list = &event->waiters;
+
+    task_scheduler_wait();
+
+    irq_master_enable();
+
+    return true;
+}
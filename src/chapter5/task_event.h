@@ -0,0 +1,20 @@
+#ifndef __TASK_EVENT_H__
+#define __TASK_EVENT_H__
+
+#include <stdbool.h>
+#include "task_scheduler.h"
+
+/* An event tasks can wait on - signalling it wakes up every task
+ * waiting at the time. If none is, the signal is kept pending and the
+ * next wait carries on right away.
+ */
+typedef struct{
+    task_desc*      waiters;
+    volatile bool   pending;
+}task_event;
+
+void task_event_init(task_event* event);
+void task_event_signal(task_event* event);
+bool task_event_wait(task_event* event);
+
+#endif /* __TASK_EVENT_H__ */
@@ -0,0 +1,105 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "irq.h"
+#include "task_scheduler.h"
+#include "task_flags.h"
+
+/* Whether a task's flags satisfy what it waits for */
+static bool task_flags_satisfied(uint32_t flags, uint32_t mask, bool all) {
+    if(all) {
+        return (flags & mask) == mask;
+    }
+
+    return (flags & mask) != 0;
+}
+
+/* Set flags of a task - from a task or an interrupt handler.
+ * Wakes the task if it is waiting on these flags, or releases
+ * it if it is dormant and these are it's trigger flags.
+ */
+void task_flags_set(task_desc* task, uint32_t flags) {
+    irq_master_disable();
+
+    task->flags |= flags;
+
+    if(task->flags_wait != 0) {
+        if(task_flags_satisfied(task->flags, task->flags_wait, task->flags_all)) {
+            task->flags_wait = 0;
+            task_scheduler_wake(task);
+        }
+    }
+    else if((task->flags & task->trigger) != 0) {
+        task_scheduler_trigger(task);
+    }
+
+    irq_master_enable();
+}
+
+/* The current task waits for any or all of the flags in mask to be set.
+ * Returns false if they already are - otherwise the task is to return,
+ * see task_wait_flags() in task_coroutine.h.
+ * The flags are left set - take them with task_flags_take().
+ */
+bool task_flags_wait(uint32_t mask, task_flags_mode mode) {
+    task_desc* self = task_scheduler_current();
+    bool all = (mode == TASK_FLAGS_ALL);
+
+    irq_master_disable();
+
+    if(mask == 0 || task_flags_satisfied(self->flags, mask, all)) {
+        irq_master_enable();
+        return false;
+    }
+
+    self->flags_wait = mask;
+    self->flags_all = all;
+    task_scheduler_wait();
+
+    irq_master_enable();
+
+    return true;
+}
+
+/* As task_flags_wait() - but the task waits no later than wake_time.
+ * Returns false if the flags are already set or wake_time has come.
+ * Once resumed, the task tells which it was by it's flags.
+ */
+bool task_flags_wait_until(uint32_t mask, task_flags_mode mode, systime_t wake_time) {
+    task_desc* self = task_scheduler_current();
+    bool all = (mode == TASK_FLAGS_ALL);
+
+    irq_master_disable();
+
+    if(mask == 0 || task_flags_satisfied(self->flags, mask, all) ||
+       !systime_after(wake_time, system_time_get())) {
+        irq_master_enable();
+        return false;
+    }
+
+    self->flags_wait = mask;
+    self->flags_all = all;
+    task_scheduler_wait_until(wake_time);
+
+    irq_master_enable();
+
+    return true;
+}
+
+/* Clear the current task's flags in mask - returns which of them were set */
+uint32_t task_flags_take(uint32_t mask) {
+    task_desc* self = task_scheduler_current();
+    uint32_t taken;
+
+    irq_master_disable();
+    taken = self->flags & mask;
+    self->flags &= ~mask;
+    irq_master_enable();
+
+    return taken;
+}
+
+/* The current task's flags - without clearing any */
+uint32_t task_flags_peek(void) {
+    return task_scheduler_current()->flags;
+}
@@ -0,0 +1,24 @@
+#ifndef __TASK_FLAGS_H__
+#define __TASK_FLAGS_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "task_scheduler.h"
+
+/* Event flags - a 32-bit word of flags per task, that tasks and interrupt
+ * handlers set and the task itself waits on and takes. A task waiting on
+ * it's flags is blocked and costs the scheduler nothing until a flag it
+ * waits on is set. Flags stay set until the task takes them.
+ */
+typedef enum{
+    TASK_FLAGS_ANY = 0,
+    TASK_FLAGS_ALL
+}task_flags_mode;
+
+void task_flags_set(task_desc* task, uint32_t flags);
+bool task_flags_wait(uint32_t mask, task_flags_mode mode);
+bool task_flags_wait_until(uint32_t mask, task_flags_mode mode, systime_t wake_time);
+uint32_t task_flags_take(uint32_t mask);
+uint32_t task_flags_peek(void);
+
+#endif /* __TASK_FLAGS_H__ */
@@ -0,0 +1,187 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "irq.h"
+#include "exclusive.h"
+#include "cycle_counter.h"
+#include "task_scheduler.h"
+#include "task_mutex.h"
+
+/* The task is the mutex's owner now - note it and start timing the hold */
+static void task_mutex_acquired(task_mutex* mutex, task_desc* owner) {
+    mutex->next_held = owner->mutexes_held;
+    owner->mutexes_held = mutex;
+    mutex->lock_cycles = cycle_counter_get();
+}
+
+/* The owner is done with the mutex - take it off the owner's list of
+ * mutexes held and fold the hold time into the statistics.
+ */
+static void task_mutex_released(task_mutex* mutex, task_desc* owner) {
+    uint32_t held = cycle_counter_get() - mutex->lock_cycles;
+    task_mutex** link;
+
+    for(link = &owner->mutexes_held; *link != NULL; link = &(*link)->next_held) {
+        if(*link == mutex) {
+            *link = mutex->next_held;
+            break;
+        }
+    }
+    mutex->next_held = NULL;
+
+    if(held > mutex->max_hold_cycles) {
+        mutex->max_hold_cycles = held;
+    }
+    mutex->total_hold_cycles += held;
+    mutex->hold_count++;
+}
+
+/* The priority the task is owed - it's base priority, or that of the
+ * highest priority task waiting on any of the mutexes it still holds.
+ */
+static uint8_t task_mutex_owed_priority(const task_desc* task) {
+    const task_mutex* mutex;
+    uint8_t priority = task->base_priority;
+
+    for(mutex = task->mutexes_held; mutex != NULL; mutex = mutex->next_held) {
+        if(mutex->waiters != NULL && mutex->waiters->priority < priority) {
+            priority = mutex->waiters->priority;
+        }
+    }
+
+    return priority;
+}
+
+/* Set up a free mutex */
+void task_mutex_init(task_mutex* mutex) {
+    mutex->owner = 0;
+    mutex->waiters = NULL;
+    mutex->next_held = NULL;
+    mutex->lock_cycles = 0;
+    mutex->hold_count = 0;
+    mutex->max_hold_cycles = 0;
+    mutex->total_hold_cycles = 0;
+}
+
+/* Lock the mutex for the current task if it is free - without disabling
+ * interrupts. Also returns true if the mutex has been handed to the task
+ * by task_mutex_unlock() while it was waiting.
+ */
+bool task_mutex_try_lock(task_mutex* mutex) {
+    task_desc* self = task_scheduler_current();
+    uint32_t owner;
+
+    do {
+        owner = exclusive_load(&mutex->owner);
+
+        if(owner != 0) {
+            exclusive_clear();
+            return (owner & ~TASK_MUTEX_CONTENDED) == (uint32_t)self;
+        }
+    }while(exclusive_store(&mutex->owner, (uint32_t)self) != 0);
+
+    task_mutex_acquired(mutex, self);
+
+    return true;
+}
+
+/* The current task waits for the mutex. Returns false if the mutex has
+ * been unlocked meanwhile (so try again) - otherwise the task is queued
+ * by priority and is to return, see task_lock() in task_coroutine.h.
+ * The owner inherits the task's priority if it is higher.
+ */
+bool task_mutex_wait(task_mutex* mutex) {
+    task_desc* self = task_scheduler_current();
+    task_desc* holder;
+    task_desc** link;
+    uint32_t owner;
+
+    irq_master_disable();
+
+    // flag the contention, so the owner's unlock takes the slow path
+    do {
+        owner = exclusive_load(&mutex->owner);
+
+        if(owner == 0) {
+            exclusive_clear();
+            irq_master_enable();
+            return false;
+        }
+    }while(exclusive_store(&mutex->owner, owner | TASK_MUTEX_CONTENDED) != 0);
+
+    // behind the waiters of the same or a higher priority
+    for(link = &mutex->waiters; *link != NULL && (*link)->priority <= self->priority; link = &(*link)->wait_next);
+    self->wait_next = *link;
+    *link = self;
+    self->wait_list = &mutex->waiters;
+
+    holder = (task_desc*)(owner & ~TASK_MUTEX_CONTENDED);
+    if(self->priority < holder->priority) {
+        task_scheduler_set_priority(holder, self->priority);
+    }
+
+    task_scheduler_wait();
+
+    irq_master_enable();
+
+    return true;
+}
+
+/* Unlock the mutex held by the current task. With no task waiting, that's
+ * a single exclusive update. Otherwise the mutex is handed to the highest
+ * priority waiter, and the task drops back to the priority it is owed.
+ */
+void task_mutex_unlock(task_mutex* mutex) {
+    task_desc* self = task_scheduler_current();
+    task_desc* next;
+    uint32_t owner;
+
+    task_mutex_released(mutex, self);
+
+    do {
+        owner = exclusive_load(&mutex->owner);
+
+        if(owner != (uint32_t)self) {
+            exclusive_clear();
+            break;
+        }
+    }while(exclusive_store(&mutex->owner, 0) != 0);
+
+    if(owner == (uint32_t)self) {
+        return;
+    }
+
+    irq_master_disable();
+
+    next = mutex->waiters;
+
+    if(next == NULL) {
+        // the waiters were all removed meanwhile
+        mutex->owner = 0;
+    }
+    else {
+        mutex->waiters = next->wait_next;
+        next->wait_next = NULL;
+        next->wait_list = NULL;
+
+        mutex->owner = (uint32_t)next | (mutex->waiters != NULL ? TASK_MUTEX_CONTENDED : 0);
+        task_mutex_acquired(mutex, next);
+
+        // the new owner inherits from the remaining waiters
+        task_scheduler_set_priority(next, task_mutex_owed_priority(next));
+        task_scheduler_wake(next);
+    }
+
+    task_scheduler_set_priority(self, task_mutex_owed_priority(self));
+
+    irq_master_enable();
+}
+
+/* Take a consistent copy of the mutex's hold time statistics */
+void task_mutex_get_stats(const task_mutex* mutex, task_mutex_stats* stats) {
+    irq_master_disable();
+    stats->hold_count = mutex->hold_count;
+    stats->max_hold_cycles = mutex->max_hold_cycles;
+    stats->total_hold_cycles = mutex->total_hold_cycles;
+    irq_master_enable();
+}
@@ -0,0 +1,50 @@
+#ifndef __TASK_MUTEX_H__
+#define __TASK_MUTEX_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "task_scheduler.h"
+
+/* A mutex for tasks sharing a resource (a peripheral, say) - with priority
+ * inheritance: while a task waits on the mutex, the owner runs at (at least)
+ * the waiter's priority, so a medium priority task can't hold the waiter up
+ * indefinitely by preempting the owner. Locking and unlocking an uncontended
+ * mutex is a single exclusive update of the owner word - interrupts are only
+ * disabled once a task has to wait. Tasks wait with task_lock() in
+ * task_coroutine.h, highest priority first, and are handed the mutex
+ * directly on unlock. It isn't recursive, and isn't for interrupt handlers.
+ *
+ * The inheritance follows the priorities - it isn't applied to the
+ * deadlines under the EDF policy, nor passed on to the owner of a
+ * mutex the owner is itself waiting on.
+ */
+#define TASK_MUTEX_CONTENDED    0x00000001u     // in the owner word - there are waiters
+
+struct task_mutex{
+    volatile uint32_t       owner;          // the owning task_desc* | TASK_MUTEX_CONTENDED, 0 - free
+    task_desc*              waiters;
+    struct task_mutex*      next_held;
+    uint32_t                lock_cycles;
+    uint32_t                hold_count;
+    uint32_t                max_hold_cycles;
+    uint64_t                total_hold_cycles;
+};
+
+typedef struct task_mutex task_mutex;
+
+#define TASK_MUTEX_INIT         { 0, NULL, NULL, 0, 0, 0, 0 }
+
+/* How long the mutex has been held for - in cycle counter cycles */
+typedef struct{
+    uint32_t                hold_count;
+    uint32_t                max_hold_cycles;
+    uint64_t                total_hold_cycles;
+}task_mutex_stats;
+
+void task_mutex_init(task_mutex* mutex);
+bool task_mutex_try_lock(task_mutex* mutex);
+bool task_mutex_wait(task_mutex* mutex);
+void task_mutex_unlock(task_mutex* mutex);
+void task_mutex_get_stats(const task_mutex* mutex, task_mutex_stats* stats);
+
+#endif /* __TASK_MUTEX_H__ */
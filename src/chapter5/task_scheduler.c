@@ -1,8 +1,636 @@
 #include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "irq.h"
+#include "uart_drv.h"
+#include "serial_print.h"
+#include "systick.h"
+#include "cycle_counter.h"
+#include "context_switch.h"
+#include "ready_queue.h"
+#include "mem_pool.h"
+#include "stack_check.h"
+#include "work_queue.h"
+#include "trace.h"
 #include "task_scheduler.h"
 
+/* The task descriptors - handed out and taken back by task_pool,
+ * so removed tasks' descriptors are reused. A free descriptor
+ * is in the TASK_FREE state (0).
+ */
 static task_desc task_list[MAX_TASKS] = {0};
-static uint8_t task_list_idx;
+static mem_pool task_pool;
+static uint16_t task_count;
+
+/* The task stacks are carved out of the SRAM between the end of .bss and
+ * the main stack - however many fit, see lm3s6965_layout.ld. They are
+ * taken only in the preemptive mode, the cooperative mode needs none.
+ */
+extern uint32_t _sram_task_stacks;
+extern uint32_t _sram_task_stacks_end;
+static mem_pool stack_pool;
+static bool pools_ready;
+
+/* The dormant tasks ordered by their next release */
+static heap_node* release_nodes[MAX_TASKS];
+static min_heap release_heap = {release_nodes, 0, MAX_TASKS};
+
+/* The ready tasks ordered by their absolute deadline - EDF policy only */
+static heap_node* edf_nodes[MAX_TASKS];
+static min_heap edf_heap = {edf_nodes, 0, MAX_TASKS};
+
+/* The releases under way that have a deadline - by the absolute deadline,
+ * so the tick only looks at the head to notice a miss
+ */
+static heap_node* deadline_nodes[MAX_TASKS];
+static min_heap deadline_heap = {deadline_nodes, 0, MAX_TASKS};
+
+/* The number of deadlines missed by all tasks - and the last miss to be
+ * logged, which the tick leaves to the work queue to print
+ */
+static volatile uint32_t total_misses;
+static task_desc* volatile miss_log_task;
+static systime_t miss_log_deadline;
+static void task_scheduler_miss_log(void* arg);
+static work_item miss_log_work = WORK_ITEM_INIT(task_scheduler_miss_log, NULL);
+
+/* The tasks whose miss hook is to be called - a bit per task_list index,
+ * left to the work queue like the log, so the hook doesn't run with
+ * interrupts disabled in the middle of the scheduler's own update
+ */
+static volatile uint32_t miss_hook_pending;
+static void task_scheduler_miss_hooks(void* arg);
+static work_item miss_hook_work = WORK_ITEM_INIT(task_scheduler_miss_hooks, NULL);
+
+static task_scheduler_policy policy;
+
+/* Sum of wcet/min(deadline, duration) of all tasks added - parts per million */
+static uint32_t utilization;
+
+/* The system time when the scheduler started running - the CPU share
+ * of each task is worked out over the time since.
+ */
+static systime_t stats_start;
+
+/* Stack for the idle loop - used in the preemptive mode only.
+ * The exception frame requires the stack pointer to be 8-byte aligned.
+ */
+static uint32_t idle_stack[IDLE_STACK_WORDS] __attribute__((aligned(8)));
+
+/* The task currently running - NULL means none (or the idle loop) */
+static task_desc* current_task;
+static uint32_t* idle_sp;
+static volatile bool preemptive;
+static bool tickless;
+
+/* The idle hook, the cycles spent asleep in the idle loop since the
+ * scheduler started - and where the last CPU load window started
+ */
+static task_idle_fptr idle_hook;
+static uint64_t idle_cycles;
+static systime_t load_start;
+static uint64_t load_idle;
+
+/* Make a released (or preempted) task ready to run under the current policy.
+ * A preempted task is put back at the front of it's priority level, so
+ * that it resumes ahead of it's peers.
+ * To be called with interrupts disabled - as are the rest of the ready_ functions.
+ */
+static void ready_push(task_desc* task, bool preempted) {
+    if(policy == SCHEDULER_POLICY_EDF) {
+        min_heap_insert(&edf_heap, &task->edf, task->edf.key);
+    }
+    else if(preempted) {
+        ready_queue_push_front(task);
+    }
+    else {
+        ready_queue_push(task);
+    }
+}
+
+/* Remove and return the next task to run under the current policy -
+ * NULL if no task is ready.
+ */
+static task_desc* ready_pop(void) {
+    heap_node* node;
+
+    if(policy == SCHEDULER_POLICY_EDF) {
+        node = min_heap_pop(&edf_heap);
+        return node == NULL ? NULL : HEAP_ENTRY(node, task_desc, edf);
+    }
+
+    return ready_queue_pop();
+}
+
+/* Take a ready task out of the ready set under the current policy */
+static void ready_remove(task_desc* task) {
+    if(policy == SCHEDULER_POLICY_EDF) {
+        min_heap_remove(&edf_heap, &task->edf);
+    }
+    else {
+        ready_queue_remove(task);
+    }
+}
+
+/* Whether there is no task ready to run */
+static bool ready_empty(void) {
+    if(policy == SCHEDULER_POLICY_EDF) {
+        return min_heap_peek(&edf_heap) == NULL;
+    }
+
+    return ready_queue_highest_prio() == TASK_PRIO_LEVELS;
+}
+
+/* Whether the next ready task is to preempt the given running task -
+ * it has a higher priority, or an earlier deadline under EDF.
+ */
+static bool ready_preempts(const task_desc* running) {
+    heap_node* node;
+
+    if(running == NULL) {
+        return !ready_empty();
+    }
+
+    if(policy == SCHEDULER_POLICY_EDF) {
+        node = min_heap_peek(&edf_heap);
+        return node != NULL && systime_before(node->key, running->edf.key);
+    }
+
+    return ready_queue_highest_prio() < running->priority;
+}
+
+/* Count how late the task's release started to run in it's jitter histogram */
+static void stats_release_jitter(task_desc* task) {
+    systime_t late = system_time_get() - task->last_run;
+    uint32_t bucket = 0;
+
+    // bucket n > 0 holds 2^(n-1) up to 2^n - 1
+    while(late != 0 && bucket < TASK_JITTER_BUCKETS - 1u) {
+        late >>= 1;
+        bucket++;
+    }
+
+    task->jitter.buckets[bucket]++;
+}
+
+/* A task as told in the trace - by it's index in the task list */
+static inline uint8_t trace_task(const task_desc* task) {
+    return (uint8_t)(task - task_list);
+}
+
+/* The task is switched in - start timing the slice it runs for.
+ * The first slice of a release also tells it's jitter.
+ */
+static inline void stats_slice_start(task_desc* task) {
+    trace_record(TRACE_TASK_IN, trace_task(task), task->priority);
+
+    if(task->undispatched) {
+        task->undispatched = false;
+        stats_release_jitter(task);
+    }
+
+    task->slice_start = cycle_counter_get();
+}
+
+/* The task is switched out (or done) - add the slice to the current release */
+static inline void stats_slice_end(task_desc* task) {
+    task->exec_cycles += cycle_counter_get() - task->slice_start;
+}
+
+/* The task is done with the current release - fold it's execution time
+ * into the task's statistics. To be called with interrupts disabled.
+ */
+static void stats_release_done(task_desc* task) {
+    task_stats* stats = &task->stats;
+
+    if(stats->run_count == 0 || task->exec_cycles < stats->min_cycles) {
+        stats->min_cycles = task->exec_cycles;
+    }
+
+    if(task->exec_cycles > stats->max_cycles) {
+        stats->max_cycles = task->exec_cycles;
+    }
+
+    stats->total_cycles += task->exec_cycles;
+    stats->run_count++;
+    task->exec_cycles = 0;
+}
+
+/* num * scale / den - again without a 64-bit division. Both are halved
+ * together until the division fits 32 bits, which only costs precision
+ * for very large values.
+ */
+static uint32_t stats_scaled_ratio(uint64_t num, uint64_t den, uint32_t scale) {
+    while(num > (0xFFFFFFFFu / scale) || den > 0xFFFFFFFFu) {
+        num >>= 1;
+        den >>= 1;
+    }
+
+    if(den == 0) {
+        return 0;
+    }
+
+    return ((uint32_t)num * scale) / (uint32_t)den;
+}
+
+/* Release a task that was due at the given time - it is ready to run from
+ * now on. The deadline is relative to when the release was due, however
+ * late it comes. To be called with interrupts disabled.
+ */
+static void task_scheduler_release(task_desc* task, systime_t due) {
+    task->last_run = due;
+    task->edf.key = due + task->deadline;
+    task->undispatched = true;
+    task->missed = false;
+
+    if(task->deadline != 0) {
+        min_heap_insert(&deadline_heap, &task->deadline_watch, task->edf.key);
+    }
+
+    task->state = TASK_READY;
+    ready_push(task, false);
+}
+
+/* The next release of a periodic task - a duration after the one before,
+ * so the phase never drifts. If that has passed already, the task is
+ * overrunning - it either catches up with a release due in the past,
+ * or skips to the first release still to come.
+ */
+static systime_t task_scheduler_next_release(task_desc* task) {
+    systime_t next = task->last_run + task->duration;
+    systime_t late;
+    systime_t missed;
+
+    // dropped after a deadline miss - see TASK_MISS_SKIP_NEXT
+    if(task->skip_next) {
+        task->skip_next = false;
+        task->jitter.skipped++;
+        next += task->duration;
+    }
+
+    late = system_time_get() - next;
+
+    if(task->overrun != TASK_OVERRUN_SKIP || (int32_t)late < 0) {
+        return next;
+    }
+
+    // the release due now is missed too - it'd only start late
+    missed = late / task->duration + 1u;
+    task->jitter.skipped += missed;
+
+    return next + missed * task->duration;
+}
+
+/* Print the last deadline miss logged - from the work queue, as the
+ * tick that noticed it is no place to wait on the serial port
+ */
+static void task_scheduler_miss_log(void* arg) {
+    task_desc* task = miss_log_task;
+
+    (void)arg;
+
+    serial_puts("deadline miss: task ");
+    serial_put_uint((uint32_t)(task - task_list));
+    serial_puts(" deadline ");
+    serial_put_uint(miss_log_deadline);
+    serial_puts(" misses ");
+    serial_put_uint(task->misses);
+    serial_putchar('\n');
+}
+
+/* Call the miss hooks of the tasks that missed since the last run - from
+ * the work queue. A task removed in the meantime is skipped.
+ */
+static void task_scheduler_miss_hooks(void* arg) {
+    uint32_t pending = __atomic_exchange_n(&miss_hook_pending, 0u, __ATOMIC_ACQUIRE);
+    uint32_t idx;
+    task_desc* task;
+
+    (void)arg;
+
+    for(idx = 0; pending != 0; idx++, pending >>= 1) {
+        task = &task_list[idx];
+        if((pending & 1u) != 0 && task->state != TASK_FREE && task->state != TASK_DELETED &&
+           task->miss_policy == TASK_MISS_HOOK && task->miss_hook != NULL) {
+            task->miss_hook(task);
+        }
+    }
+}
+
+/* The task's release has missed it's deadline - count it and act on it
+ * as the task's miss policy says. To be called with interrupts disabled.
+ */
+static void task_scheduler_deadline_missed(task_desc* task) {
+    task->missed = true;
+    task->misses++;
+    total_misses++;
+
+    switch(task->miss_policy) {
+        case TASK_MISS_SKIP_NEXT:
+            task->skip_next = true;
+            break;
+
+        case TASK_MISS_HOOK:
+            if(task->miss_hook != NULL) {
+                __atomic_fetch_or(&miss_hook_pending, 1u << (task - task_list), __ATOMIC_RELAXED);
+                work_queue_post(&miss_hook_work);
+            }
+            break;
+
+        default:
+            // if the log of an earlier miss is still pending, only the later is printed
+            miss_log_task = task;
+            miss_log_deadline = task->edf.key;
+            work_queue_post(&miss_log_work);
+            break;
+    }
+}
+
+/* Set up the descriptor and stack pools - on first use */
+static void task_scheduler_pools_init(void) {
+    uint32_t stack_bytes = TASK_STACK_WORDS * sizeof(uint32_t);
+    uint32_t stack_count = ((uint32_t)&_sram_task_stacks_end - (uint32_t)&_sram_task_stacks) / stack_bytes;
+
+    if(pools_ready) {
+        return;
+    }
+
+    if(stack_count > 0xFFFFu) {
+        stack_count = 0xFFFFu;
+    }
+
+    mem_pool_init(&task_pool, task_list, sizeof(task_desc), MAX_TASKS);
+    mem_pool_init(&stack_pool, &_sram_task_stacks, stack_bytes, (uint16_t)stack_count);
+    pools_ready = true;
+}
+
+/* Take the task out of whatever it is queued on and give it's
+ * descriptor and stack back to their pools.
+ * To be called with interrupts disabled.
+ */
+static void task_scheduler_free(task_desc* task) {
+    task_desc** link;
+
+    if(task->state == TASK_READY) {
+        ready_remove(task);
+    }
+
+    min_heap_remove(&release_heap, &task->release);
+    min_heap_remove(&deadline_heap, &task->deadline_watch);
+
+    if(task->wait_list != NULL) {
+        for(link = task->wait_list; *link != NULL; link = &(*link)->wait_next) {
+            if(*link == task) {
+                *link = task->wait_next;
+                break;
+            }
+        }
+        task->wait_list = NULL;
+    }
+
+    if(task->stack != NULL) {
+        mem_pool_free(&stack_pool, task->stack);
+        task->stack = NULL;
+    }
+
+    utilization -= task->util;
+    task_count--;
+
+    // a miss hook still pending is not for whatever takes the descriptor next
+    __atomic_fetch_and(&miss_hook_pending, ~(1u << (task - task_list)), __ATOMIC_RELAXED);
+
+    task->state = TASK_FREE;
+    mem_pool_free(&task_pool, task);
+}
+
+/* The task is to go - right away in the cooperative mode. In the preemptive
+ * mode the task may well be running on the stack to be freed, so it is only
+ * marked and then reclaimed by task_scheduler_switch().
+ * To be called with interrupts disabled.
+ */
+static void task_scheduler_task_exit(task_desc* task) {
+    if(preemptive) {
+        task->state = TASK_DELETED;
+    }
+    else {
+        task_scheduler_free(task);
+    }
+}
+
+/* Once a task's start function returns, it goes dormant
+ * until it's next release - a duration after it's last release was due.
+ * An event-triggered task with trigger flags still set is released again
+ * right away, and one with no duration waits for nothing but it's flags.
+ * A one-shot job is done for good. A release done past it's deadline -
+ * within a tick of it - is a miss too, unless the tick noticed already.
+ * To be called with interrupts disabled.
+ */
+static void task_scheduler_task_done(task_desc* task) {
+    if(min_heap_queued(&task->deadline_watch)) {
+        min_heap_remove(&deadline_heap, &task->deadline_watch);
+
+        if(systime_after(system_time_get(), task->edf.key)) {
+            task_scheduler_deadline_missed(task);
+        }
+    }
+
+    if(task->duration == 0 && task->trigger == 0) {
+        task_scheduler_task_exit(task);
+        return;
+    }
+
+    task->state = TASK_DORMANT;
+
+    if((task->flags & task->trigger) != 0) {
+        task_scheduler_release(task, system_time_get());
+        return;
+    }
+
+    if(task->duration != 0) {
+        min_heap_insert(&release_heap, &task->release, task_scheduler_next_release(task));
+    }
+}
+
+/* A task's start function has returned. A coroutine task that hasn't
+ * reached it's end is still within the same release - it either yielded
+ * (and goes to the back of the ready queue) or blocks on what it asked to
+ * wait for. Any other task is done with it's release.
+ * To be called with interrupts disabled.
+ */
+static void task_scheduler_task_returned(task_desc* task) {
+    stats_slice_end(task);
+
+    // removed while it was running
+    if(task->state == TASK_DELETED) {
+        trace_record(TRACE_TASK_OUT, trace_task(task), TRACE_OUT_DONE);
+        task_scheduler_task_exit(task);
+        return;
+    }
+
+    if(task->cr_line == 0) {
+        trace_record(TRACE_TASK_OUT, trace_task(task), TRACE_OUT_DONE);
+        stats_release_done(task);
+        task_scheduler_task_done(task);
+        return;
+    }
+
+    switch(task->wait) {
+        case TASK_WAIT_TIME:
+            // the wake up time was stashed in the (unqueued) release node
+            trace_record(TRACE_TASK_OUT, trace_task(task), TRACE_OUT_BLOCKED);
+            task->state = TASK_BLOCKED;
+            min_heap_insert(&release_heap, &task->release, task->release.key);
+            break;
+
+        case TASK_WAIT_EVENT:
+            trace_record(TRACE_TASK_OUT, trace_task(task), TRACE_OUT_BLOCKED);
+            task->state = TASK_BLOCKED;
+            break;
+
+        default:
+            trace_record(TRACE_TASK_OUT, trace_task(task), TRACE_OUT_YIELDED);
+            task->state = TASK_READY;
+            ready_push(task, false);
+            break;
+    }
+}
+
+/* Every task runs within this loop in the preemptive mode.
+ * Once the task returns, we switch away from it.
+ */
+static void task_thread(void* arg) {
+    task_desc* task = (task_desc*)arg;
+
+    while(1) {
+        task->start();
+
+        irq_master_disable();
+        task_scheduler_task_returned(task);
+        context_switch_request();
+        irq_master_enable();
+    }
+}
+
+/* Give a task a stack from the pool, set up to start in task_thread().
+ * Returns false if the pool is out of stacks.
+ */
+static bool task_scheduler_stack_alloc(task_desc* task) {
+    task->stack = (uint32_t*)mem_pool_alloc(&stack_pool);
+
+    if(task->stack == NULL) {
+        return false;
+    }
+
+    // painted - for the high-water mark
+    stack_check_paint(task->stack, &task->stack[TASK_STACK_WORDS]);
+
+    // the initial frame the task is switched to in the preemptive mode
+    task->sp = context_switch_stack_init(&task->stack[TASK_STACK_WORDS], &task_thread, task);
+
+    return true;
+}
+
+/* The number of ticks until the tick at the head of a heap is due,
+ * given as the offset from the head's key. Returns 0 if it already is.
+ */
+static systime_t task_scheduler_ticks_to(const min_heap* heap, systime_t offset) {
+    heap_node* next = min_heap_peek(heap);
+    systime_t ticks;
+
+    if(next == NULL) {
+        return (systime_t)(-1);
+    }
+
+    ticks = next->key + offset - system_time_get();
+
+    // already due if it isn't in the future
+    if((int32_t)ticks <= 0) {
+        return 0;
+    }
+
+    return ticks;
+}
+
+/* The number of ticks until the earliest release - the head of the release
+ * heap - or until the earliest deadline is missed, whichever comes first.
+ * Returns 0 if either is already due.
+ */
+static systime_t task_scheduler_ticks_to_release(void) {
+    systime_t release = task_scheduler_ticks_to(&release_heap, 0);
+    systime_t miss = task_scheduler_ticks_to(&deadline_heap, 1u);
+
+    return (miss < release) ? miss : release;
+}
+
+/* Nothing is ready to run - sleep until the next interrupt. In the tickless
+ * mode, also suppress the SysTick interrupts until the next release is due
+ * - then account for the ticks slept through in the system time. The time
+ * asleep is counted as idle - the interrupt that wakes us is only taken
+ * once interrupts are enabled again, so it's handler isn't.
+ * To be called with interrupts disabled.
+ */
+static void task_scheduler_idle_sleep(void) {
+    uint32_t start = cycle_counter_get();
+    systime_t ticks = tickless ? task_scheduler_ticks_to_release() : 0;
+
+    // a sleep of less than two ticks isn't worth reprogramming the SysTick for
+    if(ticks >= 2u) {
+        system_time_advance(systick_sleep_ticks(ticks));
+    }
+    else {
+        irq_wait();
+    }
+
+    idle_cycles += cycle_counter_get() - start;
+}
+
+/* One pass of the idle loop - run the idle hook, then sleep unless
+ * the hook (or an interrupt meanwhile) made a task ready.
+ * To be called with interrupts enabled.
+ */
+static void task_scheduler_idle_once(void) {
+    if(idle_hook != NULL) {
+        idle_hook();
+    }
+
+    irq_master_disable();
+    if(ready_empty()) {
+        task_scheduler_idle_sleep();
+    }
+    irq_master_enable();
+}
+
+/* The preemptive mode's idle loop - runs whenever no task is ready */
+static void task_scheduler_idle(void) {
+    while(1) {
+        task_scheduler_idle_once();
+    }
+}
+
+/* wcet/window in parts per million, rounded up. We don't link against
+ * libgcc - so there's no 64-bit division to fall back on. Instead, both
+ * are scaled down together (wcet rounding up, so as never to under-estimate)
+ * until the product fits in 32 bits - which it only does as long as wcet
+ * isn't past the window. A wcet of the whole window or more is taken care
+ * of first: past the window, it's more than full.
+ */
+static uint32_t task_scheduler_util_ppm(systime_t wcet, systime_t window) {
+    if(wcet >= window) {
+        return (wcet == window) ? TASK_UTIL_FULL : TASK_UTIL_FULL + 1u;
+    }
+
+    while(window > (0xFFFFFFFFu / TASK_UTIL_FULL)) {
+        window >>= 1;
+        wcet = (wcet >> 1) + (wcet & 1u);
+    }
+
+    // the rounding up may take it past the window - less than it, it's at most full
+    if(wcet > window) {
+        wcet = window;
+    }
+
+    return (wcet * TASK_UTIL_FULL + window - 1u) / window;
+}
 
 /* This function sets up our task list
  * with new tasks added by initilaizing the task_desc
@@ -10,51 +638,670 @@ static uint8_t task_list_idx;
  * A maximum of MAX_TASKS are supported
  */
 task_scheduler_err task_scheduler_add_task(task_start_fptr start, systime_t duration) {
-    task_desc new_task;
+    task_attr attr;
+
+    attr.start = start;
+    attr.duration = duration;
+    attr.priority = TASK_PRIO_DEFAULT;
+    attr.deadline = 0;
+    attr.wcet = 0;
+    attr.trigger = 0;
+    attr.overrun = TASK_OVERRUN_CATCH_UP;
+    attr.miss_policy = TASK_MISS_LOG;
+    attr.miss_hook = NULL;
+
+    return task_scheduler_add_task_attr(&attr, NULL);
+}
+
+/* Same as above - with the task's attributes passed in as a task_attr.
+ * If handle isn't NULL, it is set to point to the new task's descriptor.
+ * A task whose wcet would take the utilization of the task set
+ * past 100% is rejected - no policy could then meet all deadlines.
+ * Tasks can be added at any time from task context - also while the
+ * scheduler is running. The first release is due a duration from now.
+ */
+task_scheduler_err task_scheduler_add_task_attr(const task_attr* attr, task_desc** handle) {
+    task_desc* new_task;
+    uint32_t idx;
+    systime_t deadline = (attr->deadline == 0) ? attr->duration : attr->deadline;
+    uint32_t task_util = 0;
+
+    if(attr->priority > TASK_PRIO_LOWEST) {
+        return SCHEDULER_INVALID_PRIORITY;
+    }
 
-    if(task_list_idx >= MAX_TASKS) {
+    /* With a deadline shorter than the duration, the density
+     * wcet/deadline rather than wcet/duration has to be considered.
+     */
+    if(attr->wcet != 0) {
+        systime_t window = (attr->duration == 0 || deadline < attr->duration) ? deadline : attr->duration;
+
+        if(window == 0 || attr->wcet > window) {
+            return SCHEDULER_UTILIZATION_EXCEEDED;
+        }
+
+        task_util = task_scheduler_util_ppm(attr->wcet, window);
+    }
+
+    task_scheduler_pools_init();
+
+    new_task = (task_desc*)mem_pool_alloc(&task_pool);
+
+    if(new_task == NULL) {
         return SCHEDULER_TOO_MANY_TASKS;
     }
 
     // initilaize new task added
-    new_task.start = start;
-    new_task.duration = duration;
-    new_task.last_run = 0;
+    new_task->start = attr->start;
+    new_task->duration = attr->duration;
+    new_task->last_run = 0;
+    new_task->release.idx = HEAP_NOT_QUEUED;
+    new_task->priority = attr->priority;
+    new_task->base_priority = attr->priority;
+    new_task->deadline = deadline;
+    new_task->wcet = attr->wcet;
+    new_task->edf.idx = HEAP_NOT_QUEUED;
+    new_task->state = TASK_DORMANT;
+    new_task->wait = TASK_WAIT_NONE;
+    new_task->cr_line = 0;
+    new_task->exec_cycles = 0;
+    new_task->stats.run_count = 0;
+    new_task->stats.min_cycles = 0;
+    new_task->stats.max_cycles = 0;
+    new_task->stats.total_cycles = 0;
+    new_task->undispatched = false;
+    new_task->overrun = attr->overrun;
+    for(idx = 0; idx < TASK_JITTER_BUCKETS; idx++) {
+        new_task->jitter.buckets[idx] = 0;
+    }
+    new_task->jitter.skipped = 0;
+    new_task->deadline_watch.idx = HEAP_NOT_QUEUED;
+    new_task->miss_policy = attr->miss_policy;
+    new_task->missed = false;
+    new_task->skip_next = false;
+    new_task->misses = 0;
+    new_task->miss_hook = attr->miss_hook;
+    new_task->next = NULL;
+    new_task->wait_next = NULL;
+    new_task->wait_list = NULL;
+    new_task->flags = 0;
+    new_task->flags_wait = 0;
+    new_task->flags_all = false;
+    new_task->trigger = attr->trigger;
+    new_task->util = task_util;
+    new_task->stack = NULL;
+    new_task->mutexes_held = NULL;
+    new_task->granted = false;
+
+    // in the preemptive mode, the task needs it's stack right away
+    if(preemptive && !task_scheduler_stack_alloc(new_task)) {
+        // not to be taken for a task by whatever scans the task list
+        new_task->state = TASK_FREE;
+        mem_pool_free(&task_pool, new_task);
+        return SCHEDULER_NO_STACK;
+    }
 
-    // add initialized new task to the task list
-    task_list[task_list_idx] = new_task;
-    task_list_idx++;
+    irq_master_disable();
+
+    // admitted along with the update - a task added meanwhile from another
+    // task or a handler counts
+    if(utilization + task_util > TASK_UTIL_FULL) {
+        if(new_task->stack != NULL) {
+            mem_pool_free(&stack_pool, new_task->stack);
+            new_task->stack = NULL;
+        }
+        new_task->state = TASK_FREE;
+        mem_pool_free(&task_pool, new_task);
+        irq_master_enable();
+        return SCHEDULER_UTILIZATION_EXCEEDED;
+    }
+
+    task_count++;
+    utilization += task_util;
+
+    // the first release is due once the duration has elapsed - a one-shot job's right away
+    if(attr->duration != 0) {
+        min_heap_insert(&release_heap, &new_task->release, system_time_get() + attr->duration);
+    }
+    else if(attr->trigger == 0) {
+        task_scheduler_release(new_task, system_time_get());
+
+        if(preemptive && ready_preempts(current_task)) {
+            context_switch_request();
+        }
+    }
+
+    irq_master_enable();
+
+    if(handle != NULL) {
+        *handle = new_task;
+    }
+
+    return SCHEDULER_OKAY;
+}
+
+/* Remove a task - from a task (also the task itself) or an interrupt
+ * handler. Whatever the task was queued on, it is taken off and it's
+ * descriptor and stack are reused. A running task is stopped as soon as
+ * it's switched out in the preemptive mode - and once it returns in the
+ * cooperative mode. The task must not hold anything others wait on.
+ */
+task_scheduler_err task_scheduler_remove_task(task_desc* task) {
+    irq_master_disable();
+
+    if(task->state == TASK_FREE || task->state == TASK_DELETED) {
+        irq_master_enable();
+        return SCHEDULER_INVALID_TASK;
+    }
+
+    if(task->state == TASK_RUNNING) {
+        task->state = TASK_DELETED;
+
+        if(preemptive) {
+            context_switch_request();
+        }
+    }
+    else {
+        task_scheduler_free(task);
+    }
+
+    irq_master_enable();
 
     return SCHEDULER_OKAY;
 }
 
+/* The number of tasks added and not yet removed */
+uint16_t task_scheduler_task_count(void) {
+    return task_count;
+}
 
-/* This function is where the magic happens - 
- * the tasks in the task list are scheduled here.
+/* This function is where the magic happens -
+ * the tasks released by task_scheduler_tick() are dispatched here,
+ * highest priority first and in the order of release among equals.
  */
 void task_scheduler_run(void) {
-    uint8_t idx;
+    task_desc* curr_task;
+
+    // PendSV still runs the deferred work - at the lowest priority
+    context_switch_init();
+
+    stats_start = system_time_get();
+    load_start = stats_start;
+
     while(1) {
-        
-        // Go through each task_desc in the list
-        for(idx = 0; idx < task_list_idx; idx++) {
-            task_desc* curr_task = &task_list[idx];
-            
-            /* if the task_desc is not initialized - no valid entry function pointer
-             * move to the next task_desc
-             */
-            if(curr_task->start == NULL) {
+
+        irq_master_disable();
+        curr_task = ready_pop();
+
+        if(curr_task == NULL) {
+            irq_master_enable();
+            task_scheduler_idle_once();
+            continue;
+        }
+
+        // running before an interrupt can see it - one that removes it now
+        // only marks it, as it does any running task
+        current_task = curr_task;
+        curr_task->state = TASK_RUNNING;
+        irq_master_enable();
+
+        stats_slice_start(curr_task);
+        curr_task->start();
+
+        irq_master_disable();
+        task_scheduler_task_returned(curr_task);
+        current_task = NULL;
+        irq_master_enable();
+    }
+}
+
+/* Run the tasks in the preemptive mode - each task on it's own stack,
+ * with a higher priority task preempting a lower priority one as soon
+ * as it is released. This function only returns if there aren't enough
+ * stacks for the tasks added so far.
+ */
+task_scheduler_err task_scheduler_run_preemptive(void) {
+    uint16_t idx;
+
+    task_scheduler_pools_init();
+
+    for(idx = 0; idx < MAX_TASKS; idx++) {
+        if(task_list[idx].state != TASK_FREE && task_list[idx].stack == NULL &&
+           !task_scheduler_stack_alloc(&task_list[idx])) {
+            return SCHEDULER_NO_STACK;
+        }
+    }
+
+    context_switch_init();
+
+    stack_check_paint(idle_stack, &idle_stack[IDLE_STACK_WORDS]);
+
+    stats_start = system_time_get();
+    load_start = stats_start;
+    preemptive = true;
+
+    context_switch_start(&idle_stack[IDLE_STACK_WORDS], &task_scheduler_idle);
+
+    return SCHEDULER_OKAY;
+}
+
+/* Take a consistent copy of a task's execution time statistics */
+void task_scheduler_get_stats(const task_desc* task, task_stats* stats) {
+    irq_master_disable();
+    *stats = task->stats;
+    irq_master_enable();
+}
+
+/* Print the execution time statistics of every task over the serial port -
+ * run count, min/avg/max execution time in cycles and the share of the CPU
+ * the task has taken since the scheduler started, in hundredths of a percent -
+ * and the number of deadlines it has missed.
+ */
+void task_scheduler_print_stats(void) {
+    uint64_t elapsed = (uint64_t)(system_time_get() - stats_start) * systick_get_period();
+    task_stats stats;
+    uint32_t share;
+    uint16_t idx;
+
+    for(idx = 0; idx < MAX_TASKS; idx++) {
+        if(task_list[idx].state == TASK_FREE) {
+            continue;
+        }
+
+        task_scheduler_get_stats(&task_list[idx], &stats);
+        share = stats_scaled_ratio(stats.total_cycles, elapsed, 10000u);
+
+        serial_puts("task ");
+        serial_put_uint(idx);
+        serial_puts(": runs ");
+        serial_put_uint(stats.run_count);
+        serial_puts(" min ");
+        serial_put_uint(stats.min_cycles);
+        serial_puts(" avg ");
+        serial_put_uint(stats_scaled_ratio(stats.total_cycles, stats.run_count, 1u));
+        serial_puts(" max ");
+        serial_put_uint(stats.max_cycles);
+        serial_puts(" cycles, cpu ");
+        serial_put_uint(share / 100u);
+        serial_putchar('.');
+        serial_putchar('0' + (share % 100u) / 10u);
+        serial_putchar('0' + share % 10u);
+        serial_puts("%, misses ");
+        serial_put_uint(task_list[idx].misses);
+        serial_putchar('\n');
+    }
+}
+
+/* The most of it's stack a task has ever used, in bytes -
+ * 0 if it has no stack (the cooperative mode).
+ */
+uint32_t task_scheduler_stack_used(const task_desc* task) {
+    if(task->stack == NULL) {
+        return 0;
+    }
+
+    return (TASK_STACK_WORDS - stack_check_unused(task->stack, &task->stack[TASK_STACK_WORDS])) * sizeof(uint32_t);
+}
+
+/* The number of deadlines a task has missed */
+uint32_t task_scheduler_deadline_misses(const task_desc* task) {
+    return task->misses;
+}
+
+/* The number of deadlines missed by all tasks - including removed ones */
+uint32_t task_scheduler_total_misses(void) {
+    return total_misses;
+}
+
+/* Take a consistent copy of a task's release jitter histogram */
+void task_scheduler_get_jitter(const task_desc* task, task_jitter* jitter) {
+    uint32_t idx;
+
+    irq_master_disable();
+    for(idx = 0; idx < TASK_JITTER_BUCKETS; idx++) {
+        jitter->buckets[idx] = task->jitter.buckets[idx];
+    }
+    jitter->skipped = task->jitter.skipped;
+    irq_master_enable();
+}
+
+/* Print the release jitter histogram of every task over the serial port -
+ * the number of releases in each bucket (see TASK_JITTER_BUCKETS), from
+ * on time up, and the number of releases skipped.
+ */
+void task_scheduler_print_jitter(void) {
+    task_jitter jitter;
+    uint32_t bucket;
+    uint16_t idx;
+
+    for(idx = 0; idx < MAX_TASKS; idx++) {
+        if(task_list[idx].state == TASK_FREE) {
+            continue;
+        }
+
+        task_scheduler_get_jitter(&task_list[idx], &jitter);
+
+        serial_puts("task ");
+        serial_put_uint(idx);
+        serial_puts(": jitter");
+
+        for(bucket = 0; bucket < TASK_JITTER_BUCKETS; bucket++) {
+            serial_putchar(' ');
+            serial_put_uint(jitter.buckets[bucket]);
+        }
+
+        serial_puts(" skipped ");
+        serial_put_uint(jitter.skipped);
+        serial_putchar('\n');
+    }
+}
+
+/* Print the stack high-water marks over the serial port - of each task
+ * and the idle loop (preemptive mode) and of the main stack.
+ */
+void task_scheduler_print_stacks(void) {
+    uint16_t idx;
+
+    if(preemptive) {
+        for(idx = 0; idx < MAX_TASKS; idx++) {
+            if(task_list[idx].state == TASK_FREE) {
                 continue;
             }
-            
-            /* With a valid task_desc, check if has been run for it's duration
-             * since the last time it ran. If not, update it's last run time 
-             * and start the task by calling it's entry function
-             */
-            if(system_time_get() - curr_task->last_run >= curr_task->duration) {
-                curr_task->last_run = system_time_get();
-                curr_task->start();
-            }
+
+            serial_puts("task ");
+            serial_put_uint(idx);
+            serial_puts(": stack ");
+            serial_put_uint(task_scheduler_stack_used(&task_list[idx]));
+            serial_puts(" of ");
+            serial_put_uint(TASK_STACK_WORDS * sizeof(uint32_t));
+            serial_puts(" bytes\n");
+        }
+
+        serial_puts("idle: stack ");
+        serial_put_uint((IDLE_STACK_WORDS - stack_check_unused(idle_stack, &idle_stack[IDLE_STACK_WORDS])) * sizeof(uint32_t));
+        serial_puts(" of ");
+        serial_put_uint(IDLE_STACK_WORDS * sizeof(uint32_t));
+        serial_puts(" bytes\n");
+    }
+
+    serial_puts("main: stack ");
+    serial_put_uint(stack_check_main_used());
+    serial_puts(" of ");
+    serial_put_uint(stack_check_main_size());
+    serial_puts(" bytes\n");
+}
+
+/* Select the order in which ready tasks are dispatched.
+ * To be called before the scheduler is run.
+ */
+void task_scheduler_set_policy(task_scheduler_policy new_policy) {
+    policy = new_policy;
+}
+
+/* The utilization of the task set - in parts per million (TASK_UTIL_FULL) */
+uint32_t task_scheduler_utilization(void) {
+    return utilization;
+}
+
+/* Enable or disable the tickless idle mode - where the SysTick interrupt
+ * is suppressed while there is nothing to run.
+ */
+void task_scheduler_set_tickless(bool enable) {
+    tickless = enable;
+}
+
+/* Set the hook the idle loop calls before each sleep - NULL for none */
+void task_scheduler_set_idle_hook(task_idle_fptr hook) {
+    idle_hook = hook;
+}
+
+/* The cycles spent asleep in the idle loop since the scheduler started */
+uint64_t task_scheduler_idle_cycles(void) {
+    uint64_t cycles;
+
+    irq_master_disable();
+    cycles = idle_cycles;
+    irq_master_enable();
+
+    return cycles;
+}
+
+/* The CPU load since the last call (or since the scheduler started) - the
+ * share of the time not spent asleep in the idle loop, in hundredths of a
+ * percent. The headroom left for more tasks is 10000 less this.
+ */
+uint32_t task_scheduler_cpu_load(void) {
+    systime_t now = system_time_get();
+    uint64_t idle = task_scheduler_idle_cycles();
+    uint64_t elapsed = (uint64_t)(now - load_start) * systick_get_period();
+    uint64_t slept = idle - load_idle;
+
+    load_start = now;
+    load_idle = idle;
+
+    if(elapsed == 0) {
+        return 0;
+    }
+
+    // the window is only known to the tick, the idle time to the cycle
+    if(slept > elapsed) {
+        slept = elapsed;
+    }
+
+    return 10000u - stats_scaled_ratio(slept, elapsed, 10000u);
+}
+
+/* Print the CPU load since the last call and the headroom left over the
+ * serial port - in percent, to two decimal places
+ */
+void task_scheduler_print_load(void) {
+    uint32_t load = task_scheduler_cpu_load();
+    uint32_t headroom = 10000u - load;
+
+    serial_puts("cpu load ");
+    serial_put_uint(load / 100u);
+    serial_putchar('.');
+    serial_putchar('0' + (load % 100u) / 10u);
+    serial_putchar('0' + load % 10u);
+    serial_puts("%, headroom ");
+    serial_put_uint(headroom / 100u);
+    serial_putchar('.');
+    serial_putchar('0' + (headroom % 100u) / 10u);
+    serial_putchar('0' + headroom % 10u);
+    serial_puts("%\n");
+}
+
+/* Called on every SysTick interrupt - release the tasks that are due
+ * to be dispatched, and notice the releases that have missed their
+ * deadline. Only the heads of the release and deadline heaps are looked
+ * at, however many tasks there are. In the preemptive mode, request a
+ * context switch if a released task has a higher priority than the task
+ * currently running.
+ */
+void task_scheduler_tick(void) {
+    systime_t now = system_time_get();
+    heap_node* next;
+
+    while((next = min_heap_peek(&release_heap)) != NULL && !systime_before(now, next->key)) {
+        task_desc* task = HEAP_ENTRY(next, task_desc, release);
+
+        min_heap_remove(&release_heap, next);
+
+        // a task sleeping part way through a release just resumes
+        if(task->state == TASK_BLOCKED) {
+            task->wait = TASK_WAIT_NONE;
+            task->flags_wait = 0;
+            task->state = TASK_READY;
+            ready_push(task, false);
+            continue;
+        }
+
+        // released as of when it was due - so a late tick doesn't shift the phase
+        task_scheduler_release(task, next->key);
+    }
+
+    // releases still under way past their deadline
+    while((next = min_heap_peek(&deadline_heap)) != NULL && systime_after(now, next->key)) {
+        min_heap_remove(&deadline_heap, next);
+        task_scheduler_deadline_missed(HEAP_ENTRY(next, task_desc, deadline_watch));
+    }
+
+    if(preemptive && ready_preempts(current_task)) {
+        context_switch_request();
+    }
+}
+
+/* Called from the PendSV handler with the process stack pointer of the
+ * outgoing task (R4-R11 already stacked). Saves it, picks the next task
+ * to run and returns it's process stack pointer.
+ */
+uint32_t* task_scheduler_switch(uint32_t* sp) {
+    task_desc* next;
+
+    irq_master_disable();
+
+    if(current_task == NULL) {
+        idle_sp = sp;
+    }
+    else {
+        current_task->sp = sp;
+
+        // preempted rather than done - it resumes ahead of it's peers
+        if(current_task->state == TASK_RUNNING) {
+            trace_record(TRACE_TASK_OUT, trace_task(current_task), TRACE_OUT_PREEMPTED);
+            stats_slice_end(current_task);
+            current_task->state = TASK_READY;
+            ready_push(current_task, true);
+        }
+        // removed - now that it's off it's stack, the stack can go too
+        else if(current_task->state == TASK_DELETED) {
+            task_scheduler_free(current_task);
         }
     }
+
+    next = ready_pop();
+
+    if(next != NULL) {
+        next->state = TASK_RUNNING;
+        stats_slice_start(next);
+        sp = next->sp;
+    }
+    else {
+        sp = idle_sp;
+    }
+
+    current_task = next;
+
+    irq_master_enable();
+
+    return sp;
+}
+
+/* The task currently running - NULL if none */
+task_desc* task_scheduler_current(void) {
+    return current_task;
+}
+
+/* Where the current (coroutine) task is to resume from - see task_coroutine.h */
+uint16_t* task_scheduler_cr_line(void) {
+    return &current_task->cr_line;
+}
+
+/* The current task asks to sleep until wake_time. Returns false if
+ * that time has already come - otherwise the task is to return and
+ * is resumed by the tick at wake_time.
+ */
+bool task_scheduler_sleep_until(systime_t wake_time) {
+    if(!systime_after(wake_time, system_time_get())) {
+        return false;
+    }
+
+    irq_master_disable();
+    task_scheduler_wait_until(wake_time);
+    irq_master_enable();
+
+    return true;
+}
+
+/* The current task asks to sleep until wake_time - as above, but to be
+ * called with interrupts disabled, together with whatever else the task
+ * waits on. task_scheduler_wake() cuts the sleep short.
+ */
+void task_scheduler_wait_until(systime_t wake_time) {
+    // stashed in the (unqueued) release node until the task returns
+    current_task->release.key = wake_time;
+    current_task->wait = TASK_WAIT_TIME;
+}
+
+/* The current task asks to wait for an event - it is then to return
+ * (or be switched out) and stays blocked until task_scheduler_wake().
+ * To be called with interrupts disabled, together with queueing the
+ * task wherever the waker will find it - so no wake up is lost.
+ */
+void task_scheduler_wait(void) {
+    current_task->wait = TASK_WAIT_EVENT;
+}
+
+/* Wake a task waiting for an event - or sleeping till a timeout. If it
+ * hasn't blocked yet - it is yet to return - it's wait is simply called
+ * off. In the preemptive mode, switch to the woken task right away if it
+ * is to preempt.
+ * To be called with interrupts disabled - from a task or an interrupt handler.
+ */
+void task_scheduler_wake(task_desc* task) {
+    task->wait = TASK_WAIT_NONE;
+
+    if(task->state != TASK_BLOCKED) {
+        return;
+    }
+
+    min_heap_remove(&release_heap, &task->release);
+    task->state = TASK_READY;
+    ready_push(task, false);
+
+    if(preemptive && ready_preempts(current_task)) {
+        context_switch_request();
+    }
+}
+
+/* Release a dormant event-triggered task right away - it's trigger
+ * flags have been set. A periodic release it had queued is called off,
+ * the next one is due a duration after this one.
+ * To be called with interrupts disabled - from a task or an interrupt handler.
+ */
+void task_scheduler_trigger(task_desc* task) {
+    if(task->state != TASK_DORMANT) {
+        return;
+    }
+
+    min_heap_remove(&release_heap, &task->release);
+    task_scheduler_release(task, system_time_get());
+
+    if(preemptive && ready_preempts(current_task)) {
+        context_switch_request();
+    }
+}
+
+/* Change the priority a task is scheduled at - a ready task moves to the
+ * new level. In the preemptive mode, switch right away if the change
+ * means the running task is to be preempted.
+ * To be called with interrupts disabled.
+ */
+void task_scheduler_set_priority(task_desc* task, uint8_t priority) {
+    if(task->priority == priority) {
+        return;
+    }
+
+    if(task->state == TASK_READY && policy == SCHEDULER_POLICY_FIXED_PRIORITY) {
+        ready_queue_remove(task);
+        task->priority = priority;
+        ready_queue_push(task);
+    }
+    else {
+        task->priority = priority;
+    }
+
+    if(preemptive && ready_preempts(current_task)) {
+        context_switch_request();
+    }
 }
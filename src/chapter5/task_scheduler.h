@@ -1,27 +1,284 @@
+#ifndef __TASK_SCHEDULER_H__
+#define __TASK_SCHEDULER_H__
+
+#include <stdint.h>
+#include <stdbool.h>
 #include "system_time.h"
+#include "min_heap.h"
+
+/* Size of the pool task descriptors are taken from - tasks are added
+ * and removed at runtime, but at most this many exist at any one time.
+ */
+#define MAX_TASKS           (32u)
+
+/* Task priorities - as with the NVIC, a lower number means a higher priority */
+#define TASK_PRIO_HIGHEST   (0u)
+#define TASK_PRIO_LOWEST    (31u)
+#define TASK_PRIO_DEFAULT   (16u)
+#define TASK_PRIO_LEVELS    (32u)
+
+/* Size of the stack (in 32-bit words) given to each task when the
+ * scheduler is run in the preemptive mode. The stacks are taken from the
+ * SRAM the linker script leaves between .bss and the main stack.
+ */
+#define TASK_STACK_WORDS    (256u)
+#define IDLE_STACK_WORDS    (128u)
 
-#define MAX_TASKS   (10u)
+/* Utilization of the task set, in parts per million */
+#define TASK_UTIL_FULL      (1000000u)
+
+/* Buckets of the release jitter histogram - 0, 1, 2-3, 4-7 ... systime_t
+ * units, the last bucket taking everything from 2^(TASK_JITTER_BUCKETS-2) up
+ */
+#define TASK_JITTER_BUCKETS (8u)
+
+struct task_mutex;
 
 /* Defining a function pointer type for a task's start function/routine */
 typedef void (*task_start_fptr)(void);
 
+/* The idle hook - called whenever nothing is ready to run, before the
+ * CPU is put to sleep. It is not a task, so it mustn't wait on anything.
+ */
+typedef void (*task_idle_fptr)(void);
+
+/* The states a task moves through:
+ * free - the descriptor is unused, in the pool
+ * dormant - waiting in the release heap for it's next release
+ * ready - released and waiting to be dispatched
+ * running - currently executing (or preempted, in the preemptive mode)
+ * blocked - part way through a release, waiting on time or an event
+ * deleted - removed while running, reclaimed once it is switched out
+ */
+typedef enum{
+    TASK_FREE = 0,
+    TASK_DORMANT,
+    TASK_READY,
+    TASK_RUNNING,
+    TASK_BLOCKED,
+    TASK_DELETED
+}task_state;
+
+/* What a task has asked to wait for - the wait takes effect (the task
+ * blocks) only once it's start function returns or, for a task blocking
+ * on it's own stack in the preemptive mode, once it is switched out.
+ */
+typedef enum{
+    TASK_WAIT_NONE = 0,
+    TASK_WAIT_TIME,
+    TASK_WAIT_EVENT
+}task_wait;
+
+/* Execution time statistics of a task - in cycle counter cycles.
+ * The execution time of a release excludes any time the task spent
+ * preempted by other tasks.
+ */
+typedef struct{
+    uint32_t            run_count;
+    uint32_t            min_cycles;
+    uint32_t            max_cycles;
+    uint64_t            total_cycles;
+}task_stats;
+
+/* What a periodic task does about the releases it missed - when a release
+ * isn't done by the time the next is due:
+ * catch up - every missed release still runs, back to back, until the
+ * task is back in phase
+ * skip - the missed releases are dropped (and counted) and the task is next
+ * released at the first point of it's phase still to come
+ * Either way, releases stay tied to the phase of the first release - a late
+ * dispatch doesn't push the later releases back.
+ */
+typedef enum{
+    TASK_OVERRUN_CATCH_UP = 0,
+    TASK_OVERRUN_SKIP
+}task_overrun;
+
+/* What is done when a task misses the deadline of a release - that is, it
+ * isn't done by then. The miss is counted in any case, as soon as the tick
+ * at the deadline notices it:
+ * log - a message is printed (from the work queue, not the tick) and the
+ * task carries on
+ * skip - the task carries on, but it's next release is dropped to let it
+ * catch up
+ * hook - the task's miss hook is called, from the work queue
+ */
+typedef enum{
+    TASK_MISS_LOG = 0,
+    TASK_MISS_SKIP_NEXT,
+    TASK_MISS_HOOK
+}task_miss_policy;
+
+typedef struct task_desc task_desc;
+
+/* A task's deadline miss hook - called from the work queue (the PendSV
+ * handler) some time after the miss, with interrupts enabled, so it may
+ * use the kernel calls an interrupt handler may. Misses of the same task
+ * before it runs are called for once - task->misses has the count.
+ */
+typedef void (*task_miss_fptr)(task_desc* task);
+
+/* The release jitter of a task - how late, in systime_t units, each
+ * release started to run after the point it was due at - as a histogram,
+ * see TASK_JITTER_BUCKETS. Also the number of releases skipped.
+ */
+typedef struct{
+    uint32_t            buckets[TASK_JITTER_BUCKETS];
+    uint32_t            skipped;
+}task_jitter;
+
 /* Task descriptor that includes
  * a pointer to the entry function of the task
  * the duration of the task in systime_t units
- * the last systime_t when the task was run
+ * the systime_t the last release was due at - the ideal release, however
+ * late it was dispatched
+ * the next systime_t the task is due to be released (while dormant, queued
+ * in the release heap under this key)
+ * the priority of the task - raised above it's base priority while it holds
+ * a mutex a higher priority task waits on (priority inheritance)
+ * the relative deadline and worst-case execution time of the task
+ * the absolute deadline of the current release - the key of the EDF ready heap
+ * the node the release is watched for a deadline miss by (queued under the
+ * absolute deadline while the release is under way)
+ * the current state of the task and what it is waiting for
+ * the line a coroutine task resumes at (0 - from the start)
+ * the cycle count when the task was last switched in and the cycles it
+ * has executed for in the current release
+ * the execution time statistics of the task
+ * whether the current release has yet to be dispatched, what is done about
+ * missed releases and the release jitter histogram
+ * what is done about a deadline miss - whether the current release has
+ * missed it's deadline and whether the next release is to be skipped, the
+ * number of deadlines missed and the miss hook
+ * the saved process stack pointer of the task (preemptive mode only)
+ * the next task in the same ready queue priority level
+ * the next task waiting on the same event - kept apart from the ready queue
+ * link, as a task can be preempted after it has queued itself to wait - and
+ * the head of the list of waiters the task is queued on (NULL - none)
+ * the task's event flags, the flags it is waiting on (0 - none) and whether
+ * it waits for all of them rather than any one
+ * the event flags that release the task (0 - released by time only)
+ * the task's share of the utilization, in parts per million
+ * the task's stack, taken from the stack pool (preemptive mode only)
+ * the mutexes the task holds, most recently locked first
+ * whether what the task waited for was handed to it directly (a semaphore)
  */
-typedef struct{
+struct task_desc{
     task_start_fptr     start;
     systime_t           duration;
     systime_t           last_run;
-}task_desc;
+    heap_node           release;
+    uint8_t             priority;
+    uint8_t             base_priority;
+    systime_t           deadline;
+    systime_t           wcet;
+    heap_node           edf;
+    heap_node           deadline_watch;
+    volatile task_state state;
+    volatile uint8_t    wait;
+    uint16_t            cr_line;
+    uint32_t            slice_start;
+    uint32_t            exec_cycles;
+    task_stats          stats;
+    bool                undispatched;
+    uint8_t             overrun;
+    task_jitter         jitter;
+    uint8_t             miss_policy;
+    bool                missed;
+    bool                skip_next;
+    volatile uint32_t   misses;
+    task_miss_fptr      miss_hook;
+    uint32_t*           sp;
+    task_desc*          next;
+    task_desc*          wait_next;
+    task_desc**         wait_list;
+    volatile uint32_t   flags;
+    uint32_t            flags_wait;
+    bool                flags_all;
+    uint32_t            trigger;
+    uint32_t            util;
+    uint32_t*           stack;
+    struct task_mutex*  mutexes_held;
+    volatile bool       granted;
+};
+
+/* Attributes a task is added to the scheduler with.
+ * The deadline is relative to each release - 0 means the deadline is
+ * the same as the duration. A wcet of 0 means it isn't known - such a
+ * task isn't considered in the admission control.
+ * A task with trigger flags is also released whenever one of them is set
+ * while it is dormant - with a duration of 0, that is it's only release.
+ * Such a task's deadline doubles as the minimum time between events for
+ * the admission control.
+ * A task with neither a duration nor trigger flags is a one-shot job - it is
+ * released as soon as it is added and removed once it's release is done.
+ * The overrun policy is a task_overrun - 0 (catch up) by default.
+ * The miss policy is a task_miss_policy - 0 (log) by default. The miss hook
+ * is only called under TASK_MISS_HOOK. A task with a deadline of 0 and no
+ * duration has no deadline to miss.
+ */
+typedef struct{
+    task_start_fptr     start;
+    systime_t           duration;
+    uint8_t             priority;
+    systime_t           deadline;
+    systime_t           wcet;
+    uint32_t            trigger;
+    uint8_t             overrun;
+    uint8_t             miss_policy;
+    task_miss_fptr      miss_hook;
+}task_attr;
+
+/* Scheduling policies - the order in which ready tasks are dispatched:
+ * fixed priority - by priority, and in the order of release among equals
+ * earliest deadline first - by the absolute deadline of the release
+ */
+typedef enum{
+    SCHEDULER_POLICY_FIXED_PRIORITY = 0,
+    SCHEDULER_POLICY_EDF
+}task_scheduler_policy;
 
 /* Error enumerations for the scheduler */
 typedef enum{
     SCHEDULER_OKAY = 0,
-    SCHEDULER_TOO_MANY_TASKS
+    SCHEDULER_TOO_MANY_TASKS,
+    SCHEDULER_UTILIZATION_EXCEEDED,
+    SCHEDULER_INVALID_PRIORITY,
+    SCHEDULER_NO_STACK,
+    SCHEDULER_INVALID_TASK
 }task_scheduler_err;
 
 task_scheduler_err task_scheduler_add_task(task_start_fptr start, systime_t duration);
+task_scheduler_err task_scheduler_add_task_attr(const task_attr* attr, task_desc** handle);
+task_scheduler_err task_scheduler_remove_task(task_desc* task);
+uint16_t task_scheduler_task_count(void);
+void task_scheduler_set_policy(task_scheduler_policy policy);
+uint32_t task_scheduler_utilization(void);
+void task_scheduler_get_stats(const task_desc* task, task_stats* stats);
+void task_scheduler_print_stats(void);
+void task_scheduler_get_jitter(const task_desc* task, task_jitter* jitter);
+void task_scheduler_print_jitter(void);
+uint32_t task_scheduler_deadline_misses(const task_desc* task);
+uint32_t task_scheduler_total_misses(void);
+uint32_t task_scheduler_stack_used(const task_desc* task);
+void task_scheduler_print_stacks(void);
 void task_scheduler_run(void);
+task_scheduler_err task_scheduler_run_preemptive(void);
+void task_scheduler_tick(void);
+void task_scheduler_set_tickless(bool enable);
+void task_scheduler_set_idle_hook(task_idle_fptr hook);
+uint64_t task_scheduler_idle_cycles(void);
+uint32_t task_scheduler_cpu_load(void);
+void task_scheduler_print_load(void);
+uint32_t* task_scheduler_switch(uint32_t* sp);
+
+task_desc* task_scheduler_current(void);
+uint16_t* task_scheduler_cr_line(void);
+bool task_scheduler_sleep_until(systime_t wake_time);
+void task_scheduler_wait_until(systime_t wake_time);
+void task_scheduler_wait(void);
+void task_scheduler_wake(task_desc* task);
+void task_scheduler_trigger(task_desc* task);
+void task_scheduler_set_priority(task_desc* task, uint8_t priority);
 
+#endif /* __TASK_SCHEDULER_H__ */
@@ -0,0 +1,123 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "irq.h"
+#include "exclusive.h"
+#include "task_scheduler.h"
+#include "trace.h"
+#include "task_sem.h"
+
+/* Set up a semaphore with the given count and no waiters */
+void task_sem_init(task_sem* sem, uint32_t count) {
+    sem->count = count;
+    sem->waiters = NULL;
+}
+
+/* Take the semaphore for the current task if the count allows - without
+ * disabling interrupts. Also returns true if the semaphore has been handed
+ * to the task by task_sem_give() while it was waiting.
+ */
+bool task_sem_try_take(task_sem* sem) {
+    task_desc* self = task_scheduler_current();
+    uint32_t count;
+
+    if(self->granted) {
+        self->granted = false;
+        trace_record(TRACE_SEM_TAKE, trace_sat(sem->count), trace_obj(sem));
+        return true;
+    }
+
+    do {
+        count = exclusive_load(&sem->count);
+
+        if(count == 0) {
+            exclusive_clear();
+            return false;
+        }
+    }while(exclusive_store(&sem->count, count - 1u) != 0);
+
+    trace_record(TRACE_SEM_TAKE, trace_sat(count - 1u), trace_obj(sem));
+
+    return true;
+}
+
+/* The current task waits for the semaphore. Returns false if it has been
+ * given meanwhile (so try again) - otherwise the task is queued by priority
+ * and is to return, see task_take() in task_coroutine.h.
+ */
+bool task_sem_wait(task_sem* sem) {
+    task_desc* self = task_scheduler_current();
+    task_desc** link;
+
+    irq_master_disable();
+
+    if(sem->count != 0) {
+        irq_master_enable();
+        return false;
+    }
+
+    // behind the waiters of the same or a higher priority
+    for(link = &sem->waiters; *link != NULL && (*link)->priority <= self->priority; link = &(*link)->wait_next);
+    self->wait_next = *link;
+    *link = self;
+    self->wait_list = &sem->waiters;
+
+    task_scheduler_wait();
+    trace_record(TRACE_SEM_WAIT, 0, trace_obj(sem));
+
+    irq_master_enable();
+
+    return true;
+}
+
+/* Give the semaphore - from a task or an interrupt handler. With no task
+ * waiting, the count goes up by a single exclusive update - the waiters
+ * are checked within it, so a task that starts waiting meanwhile makes
+ * the update fail and be retried. Otherwise the highest priority waiter
+ * is handed the semaphore and woken.
+ */
+void task_sem_give(task_sem* sem) {
+    task_desc* next;
+    uint32_t count;
+    bool contended = false;
+
+    do {
+        count = exclusive_load(&sem->count);
+
+        if(sem->waiters != NULL) {
+            exclusive_clear();
+            contended = true;
+            break;
+        }
+    }while(exclusive_store(&sem->count, count + 1u) != 0);
+
+    if(!contended) {
+        trace_record(TRACE_SEM_GIVE, trace_sat(count + 1u), trace_obj(sem));
+        return;
+    }
+
+    irq_master_disable();
+
+    next = sem->waiters;
+
+    if(next == NULL) {
+        // the waiter was woken or removed meanwhile
+        sem->count++;
+    }
+    else {
+        sem->waiters = next->wait_next;
+        next->wait_next = NULL;
+        next->wait_list = NULL;
+        next->granted = true;
+        task_scheduler_wake(next);
+    }
+
+    trace_record(TRACE_SEM_GIVE, trace_sat(sem->count), trace_obj(sem));
+
+    irq_master_enable();
+}
+
+/* The current count */
+uint32_t task_sem_count(const task_sem* sem) {
+    return sem->count;
+}
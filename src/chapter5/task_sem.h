@@ -0,0 +1,29 @@
+#ifndef __TASK_SEM_H__
+#define __TASK_SEM_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "task_scheduler.h"
+
+/* A counting semaphore - given by tasks and interrupt handlers, taken by
+ * tasks (waiting with task_take() in task_coroutine.h while the count is 0).
+ * With no task waiting, a give or take is a single exclusive update of the
+ * count. With tasks waiting, a give doesn't touch the count - it is handed
+ * straight to the highest priority waiter, which is made ready (and in the
+ * preemptive mode, switched to if it is to preempt) without having to take
+ * the semaphore again when it runs.
+ */
+typedef struct{
+    volatile uint32_t   count;
+    task_desc*          waiters;
+}task_sem;
+
+#define TASK_SEM_INIT(initial)  { (initial), NULL }
+
+void task_sem_init(task_sem* sem, uint32_t count);
+bool task_sem_try_take(task_sem* sem);
+bool task_sem_wait(task_sem* sem);
+void task_sem_give(task_sem* sem);
+uint32_t task_sem_count(const task_sem* sem);
+
+#endif /* __TASK_SEM_H__ */
@@ -0,0 +1,171 @@
+#!/usr/bin/env python3
+"""Generate the frame table of a cyclic executive from a static task table.
+
+Works out the hyperperiod (the lcm of the periods) and a minor frame that
+meets the usual frame constraints, packs every job of the hyperperiod into
+a frame no earlier than it's release and ending no later than it's deadline,
+and writes the result as a const table - in flash - for cyclic_exec_run().
+
+The task table has a line per task - the start function, period, wcet and
+optionally the deadline (defaults to the period), in systime_t units (ms) -
+and the headers that declare the functions:
+
+    include example_tasks.h
+    task example_cyclic_sample   5  1
+
+usage: gen_cyclic.py cyclic_tasks.def -o cyclic_schedule.c
+"""
+
+import argparse
+import math
+import os
+import sys
+
+
+class Task:
+    def __init__(self, name, period, wcet, deadline):
+        self.name = name
+        self.period = period
+        self.wcet = wcet
+        self.deadline = deadline
+
+
+def parse(path):
+    includes, tasks = [], []
+
+    with open(path) as f:
+        for num, line in enumerate(f, 1):
+            words = line.split("#", 1)[0].split()
+            if not words:
+                continue
+
+            if words[0] == "include" and len(words) == 2:
+                includes.append(words[1])
+            elif words[0] == "task" and len(words) in (4, 5):
+                period, wcet = int(words[2]), int(words[3])
+                deadline = int(words[4]) if len(words) == 5 else period
+                if period <= 0 or wcet <= 0 or not wcet <= deadline <= period:
+                    sys.exit("%s:%d: need 0 < wcet <= deadline <= period" % (path, num))
+                tasks.append(Task(words[1], period, wcet, deadline))
+            else:
+                sys.exit("%s:%d: can't make sense of: %s" % (path, num, line.strip()))
+
+    if not tasks:
+        sys.exit("%s: no tasks" % path)
+
+    return includes, tasks
+
+
+def frame_sizes(tasks, hyperperiod):
+    """The minor frame sizes that meet the frame constraints, largest first:
+    no job is split across frames (f >= every wcet), the frames fit the
+    hyperperiod (f divides it) and there's a whole frame between each
+    release and it's deadline (2f - gcd(f, period) <= deadline)"""
+    longest = max(t.wcet for t in tasks)
+    sizes = []
+
+    for f in range(hyperperiod, longest - 1, -1):
+        if hyperperiod % f != 0:
+            continue
+        if all(2 * f - math.gcd(f, t.period) <= t.deadline for t in tasks):
+            sizes.append(f)
+
+    return sizes
+
+
+def pack(tasks, hyperperiod, frame):
+    """Place every job of the hyperperiod in a frame - earliest deadline
+    first, each into the earliest frame it fits in. Returns the jobs of
+    each frame in the order they run, or None if they don't fit."""
+    count = hyperperiod // frame
+    frames = [[] for _ in range(count)]
+    free = [frame] * count
+    jobs = []
+
+    for t in tasks:
+        for release in range(0, hyperperiod, t.period):
+            jobs.append((release + t.deadline, release, t))
+
+    for deadline, release, t in sorted(jobs, key=lambda j: (j[0], j[1])):
+        first = -(-release // frame)
+        last = deadline // frame - 1
+
+        for j in range(first, last + 1):
+            if free[j] >= t.wcet:
+                free[j] -= t.wcet
+                frames[j].append(t)
+                break
+        else:
+            return None
+
+    return frames
+
+
+def emit(out, source, includes, tasks, hyperperiod, frame, frames):
+    util = sum(t.wcet / t.period for t in tasks)
+    entries = [t.name for jobs in frames for t in jobs]
+
+    out.write("/* Generated by tools/gen_cyclic.py from %s - do not edit.\n" % os.path.basename(source))
+    out.write(" * hyperperiod %d, minor frame %d (%d frames), utilization %.1f%%\n"
+              % (hyperperiod, frame, len(frames), util * 100.0))
+    for t in tasks:
+        out.write(" * %s: period %d wcet %d deadline %d\n" % (t.name, t.period, t.wcet, t.deadline))
+    out.write(" */\n")
+    out.write("#include <stdio.h>\n")
+    out.write('#include "cyclic_exec.h"\n')
+    for inc in includes:
+        out.write('#include "%s"\n' % inc)
+    out.write("\n")
+
+    out.write("static const task_start_fptr cyclic_entries[%d] = {\n" % len(entries))
+    for name in entries:
+        out.write("    &%s,\n" % name)
+    out.write("};\n\n")
+
+    out.write("static const cyclic_frame cyclic_frames[%d] = {\n" % len(frames))
+    first = 0
+    for j, jobs in enumerate(frames):
+        busy = sum(t.wcet for t in jobs)
+        out.write("    {%du, %du},%s// %d: %d of %d\n"
+                  % (first, len(jobs), " " * max(1, 12 - len("%d%d" % (first, len(jobs)))),
+                     j, busy, frame))
+        first += len(jobs)
+    out.write("};\n\n")
+
+    out.write("const cyclic_schedule cyclic_schedule_table = {\n")
+    out.write("    %du,\n" % frame)
+    out.write("    %du,\n" % len(frames))
+    out.write("    cyclic_frames,\n")
+    out.write("    cyclic_entries\n")
+    out.write("};\n")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("table", help="the task table")
+    parser.add_argument("-o", "--output", help="C file to write (default: stdout)")
+    args = parser.parse_args()
+
+    includes, tasks = parse(args.table)
+    hyperperiod = 1
+    for t in tasks:
+        hyperperiod = hyperperiod * t.period // math.gcd(hyperperiod, t.period)
+
+    if hyperperiod > 0xFFFF:
+        sys.exit("hyperperiod %d is too long for a frame table" % hyperperiod)
+
+    for frame in frame_sizes(tasks, hyperperiod):
+        frames = pack(tasks, hyperperiod, frame)
+        if frames is not None:
+            break
+    else:
+        sys.exit("no minor frame fits the task table - split the longer tasks")
+
+    out = open(args.output, "w") if args.output else sys.stdout
+    emit(out, args.table, includes, tasks, hyperperiod, frame, frames)
+    if args.output:
+        out.close()
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,182 @@
+#!/usr/bin/env python3
+"""Convert a scheduler trace dump to Chrome/Perfetto trace JSON.
+
+The dump is picked out of the raw serial output captured off the board
+(or QEMU's -serial file:...) - see trace_dump() in trace.c for the format.
+Open the JSON in chrome://tracing or https://ui.perfetto.dev
+
+usage: trace_to_chrome.py capture.bin [-o trace.json] [--dump N]
+"""
+
+import argparse
+import json
+import struct
+import sys
+
+MAGIC = b"TRC1"
+HEADER = struct.Struct("<III")      # cycle counter hz, records, overwritten
+RECORD = struct.Struct("<IBBH")     # cycles, event, id, arg
+
+# trace_event in trace.h
+TASK_IN, TASK_OUT, ISR_ENTER, ISR_EXIT = 1, 2, 3, 4
+QUEUE_SEND, QUEUE_RECEIVE, SEM_GIVE, SEM_TAKE, SEM_WAIT = 5, 6, 7, 8, 9
+
+OUT_REASONS = ["done", "yielded", "blocked", "preempted"]
+EXCEPTIONS = {14: "PendSV", 15: "SysTick", 21: "UART0"}
+SYNC_EVENTS = {
+    QUEUE_SEND: ("queue send", "queued"),
+    QUEUE_RECEIVE: ("queue receive", "queued"),
+    SEM_GIVE: ("sem give", "count"),
+    SEM_TAKE: ("sem take", "count"),
+    SEM_WAIT: ("sem wait", None),
+}
+
+# a thread (track) each for the tasks, the interrupts and the sync objects
+PID = 1
+ISR_TID_BASE = 1000
+SYNC_TID = 2000
+
+
+def find_dumps(data):
+    """The offsets of every complete dump in the capture"""
+    dumps = []
+    pos = data.find(MAGIC)
+
+    while pos >= 0:
+        start = pos + len(MAGIC)
+
+        if start + HEADER.size <= len(data):
+            hz, count, _ = HEADER.unpack_from(data, start)
+
+            if hz != 0 and start + HEADER.size + count * RECORD.size <= len(data):
+                dumps.append(pos)
+
+        pos = data.find(MAGIC, pos + 1)
+
+    return dumps
+
+
+def parse_dump(data, pos):
+    """The header and records of the dump at pos - with the 32-bit cycle
+    counts unwrapped into a monotonic count"""
+    start = pos + len(MAGIC)
+    hz, count, overwritten = HEADER.unpack_from(data, start)
+    offset = start + HEADER.size
+    records = []
+    last = None
+    wraps = 0
+
+    for _ in range(count):
+        cycles, event, ident, arg = RECORD.unpack_from(data, offset)
+        offset += RECORD.size
+
+        # the count only goes back by (nearly) a whole wrap when it wraps -
+        # a small step back is out of order records, not a wrap
+        if last is not None and last - cycles > (1 << 31):
+            wraps += 1
+        last = cycles
+
+        records.append(((wraps << 32) + cycles, event, ident, arg))
+
+    return hz, overwritten, records
+
+
+def to_chrome(hz, records):
+    """The trace events - tasks and interrupts as duration events on a
+    track each, queue and semaphore operations as instant events"""
+    events = []
+    threads = {}
+    base = records[0][0] if records else 0
+
+    def ts(cycles):
+        return (cycles - base) * 1e6 / hz
+
+    def thread(tid, name):
+        if tid not in threads:
+            threads[tid] = name
+
+    for cycles, event, ident, arg in records:
+        if event == TASK_IN:
+            thread(ident, "task %d" % ident)
+            events.append({"name": "task %d" % ident, "ph": "B", "pid": PID,
+                           "tid": ident, "ts": ts(cycles),
+                           "args": {"priority": arg}})
+        elif event == TASK_OUT:
+            thread(ident, "task %d" % ident)
+            reason = OUT_REASONS[arg] if arg < len(OUT_REASONS) else str(arg)
+            events.append({"name": "task %d" % ident, "ph": "E", "pid": PID,
+                           "tid": ident, "ts": ts(cycles),
+                           "args": {"out": reason}})
+        elif event in (ISR_ENTER, ISR_EXIT):
+            name = EXCEPTIONS.get(ident, "exception %d" % ident)
+            tid = ISR_TID_BASE + ident
+            thread(tid, name)
+            events.append({"name": name, "ph": "B" if event == ISR_ENTER else "E",
+                           "pid": PID, "tid": tid, "ts": ts(cycles)})
+        elif event in SYNC_EVENTS:
+            name, what = SYNC_EVENTS[event]
+            args = {"object": "0x%04x" % arg}
+            if what is not None:
+                args[what] = ident
+            thread(SYNC_TID, "queues & semaphores")
+            events.append({"name": name, "ph": "i", "s": "t", "pid": PID,
+                           "tid": SYNC_TID, "ts": ts(cycles), "args": args})
+
+    # a dump starts part way through whatever was running - drop the unmatched ends
+    depth = {}
+    matched = []
+    for ev in events:
+        key = ev["tid"]
+        if ev["ph"] == "B":
+            depth[key] = depth.get(key, 0) + 1
+        elif ev["ph"] == "E":
+            if depth.get(key, 0) == 0:
+                continue
+            depth[key] -= 1
+        matched.append(ev)
+
+    meta = [{"name": "process_name", "ph": "M", "pid": PID,
+             "args": {"name": "lm3s6965"}}]
+    for tid, name in sorted(threads.items()):
+        meta.append({"name": "thread_name", "ph": "M", "pid": PID, "tid": tid,
+                     "args": {"name": name}})
+        meta.append({"name": "thread_sort_index", "ph": "M", "pid": PID, "tid": tid,
+                     "args": {"sort_index": tid}})
+
+    return meta + matched
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("capture", help="raw serial output holding a trace dump")
+    parser.add_argument("-o", "--output", help="JSON file to write (default: stdout)")
+    parser.add_argument("--dump", type=int, default=-1,
+                        help="which dump in the capture to convert (default: the last)")
+    args = parser.parse_args()
+
+    with open(args.capture, "rb") as f:
+        data = f.read()
+
+    dumps = find_dumps(data)
+    if not dumps:
+        sys.exit("no complete trace dump in %s" % args.capture)
+
+    try:
+        pos = dumps[args.dump]
+    except IndexError:
+        sys.exit("only %d dump(s) in %s" % (len(dumps), args.capture))
+
+    hz, overwritten, records = parse_dump(data, pos)
+    trace = {"traceEvents": to_chrome(hz, records), "displayTimeUnit": "ns"}
+
+    out = open(args.output, "w") if args.output else sys.stdout
+    json.dump(trace, out)
+    if args.output:
+        out.close()
+
+    print("%d records at %d Hz, %d overwritten before them" % (len(records), hz, overwritten),
+          file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,154 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "exclusive.h"
+#include "cycle_counter.h"
+#include "uart_drv.h"
+#include "task_scheduler.h"
+#include "task_flags.h"
+#include "trace.h"
+
+#define TRACE_DUMP_KICK     (0x1u)  // dump task flag - a dump was asked for
+
+/* The trace buffer - records are written at the total count written so far,
+ * modulo the size. A slot is claimed by a single exclusive update of the
+ * count, so tasks and interrupt handlers trace without disabling interrupts
+ * - an interrupt taken part way through a record just claims the next slot.
+ */
+static trace_entry trace_buf[TRACE_RECORDS];
+static volatile uint32_t trace_count;
+static volatile bool trace_on;
+static task_desc* volatile trace_dumper = NULL;
+
+/* Clear the trace buffer and start tracing */
+void trace_start(void) {
+    trace_on = false;
+    trace_count = 0;
+    trace_on = true;
+}
+
+/* Stop tracing - the records are kept until the next start */
+void trace_stop(void) {
+    trace_on = false;
+}
+
+/* Write a record of an event - from a task or an interrupt handler.
+ * A few cycles when tracing, a test and a branch when not.
+ */
+void trace_record(uint8_t event, uint8_t id, uint16_t arg) {
+    trace_entry* entry;
+    uint32_t count;
+    uint32_t cycles;
+
+    if(!trace_on) {
+        return;
+    }
+
+    // timestamped within the claim - so an interrupt that traces meanwhile
+    // forces a retry, and the records stay in the order of their times
+    do {
+        count = exclusive_load(&trace_count);
+        cycles = cycle_counter_get();
+    }while(exclusive_store(&trace_count, count + 1u) != 0);
+
+    entry = &trace_buf[count & (TRACE_RECORDS - 1u)];
+    entry->cycles = cycles;
+    entry->event = event;
+    entry->id = id;
+    entry->arg = arg;
+}
+
+/* Send a word over the serial port - least significant byte first */
+static void trace_tx_word(uint32_t word) {
+    uint32_t idx;
+
+    for(idx = 0; idx < 4u; idx++) {
+        uart_tx_byte((uint8_t)(word >> (8u * idx)));
+    }
+}
+
+/* Dump the trace over the serial port in binary - for a host tool to pick
+ * out of the captured output (see tools/trace_to_chrome.py):
+ * TRACE_DUMP_MAGIC, the cycle counter frequency, the number of records
+ * that follow and the number overwritten before them - all 32-bit little
+ * endian - then the records, oldest first, 8 bytes each as trace_entry.
+ * Tracing is stopped for the dump and started afresh after it. This takes
+ * a while at 115200 baud (~360 ms) - so it's done from a low priority task,
+ * see trace_dump_request().
+ */
+void trace_dump(void) {
+    const char* magic = TRACE_DUMP_MAGIC;
+    uint32_t count;
+    uint32_t first;
+    uint32_t idx;
+    trace_entry* entry;
+
+    trace_stop();
+    count = trace_count;
+    first = (count > TRACE_RECORDS) ? count - TRACE_RECORDS : 0;
+
+    while(*magic != '\0') {
+        uart_tx_byte((uint8_t)*magic++);
+    }
+
+    trace_tx_word(cycle_counter_hz());
+    trace_tx_word(count - first);
+    trace_tx_word(first);
+
+    for(idx = first; idx != count; idx++) {
+        entry = &trace_buf[idx & (TRACE_RECORDS - 1u)];
+        trace_tx_word(entry->cycles);
+        uart_tx_byte(entry->event);
+        uart_tx_byte(entry->id);
+        uart_tx_byte((uint8_t)entry->arg);
+        uart_tx_byte((uint8_t)(entry->arg >> 8));
+    }
+
+    trace_start();
+}
+
+/* The dump task - released by a request */
+static void trace_dump_task(void) {
+    task_flags_take(TRACE_DUMP_KICK);
+    trace_dump();
+}
+
+/* Add the dump task at the given priority - the lowest is best, so the dump
+ * only holds up the tasks in the cooperative mode, and nothing at all in
+ * the preemptive mode.
+ */
+task_scheduler_err trace_service_start(uint8_t priority) {
+    task_attr attr = {0};
+    task_desc* dumper;
+    task_scheduler_err err;
+
+    if(trace_dumper != NULL) {
+        return SCHEDULER_OKAY;
+    }
+
+    attr.start = &trace_dump_task;
+    attr.priority = priority;
+    attr.trigger = TRACE_DUMP_KICK;
+
+    err = task_scheduler_add_task_attr(&attr, &dumper);
+
+    if(err == SCHEDULER_OKAY) {
+        trace_dumper = dumper;
+    }
+
+    return err;
+}
+
+/* Ask for a dump - from a task, an interrupt handler or the work queue.
+ * Returns false if the dump task isn't running.
+ */
+bool trace_dump_request(void) {
+    task_desc* dumper = trace_dumper;
+
+    if(dumper == NULL) {
+        return false;
+    }
+
+    task_flags_set(dumper, TRACE_DUMP_KICK);
+    return true;
+}
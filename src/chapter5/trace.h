@@ -0,0 +1,76 @@
+#ifndef __TRACE_H__
+#define __TRACE_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "task_scheduler.h"
+
+/* Size of the trace buffer in records - a power of two, 8 bytes each.
+ * Once full, the oldest records are overwritten.
+ */
+#define TRACE_RECORDS       (512u)
+
+/* Marks the start of a dump in what is captured off the serial port */
+#define TRACE_DUMP_MAGIC    "TRC1"
+
+/* The events traced - and what the id and arg of their records hold:
+ * task in - id: the task, arg: it's priority
+ * task out - id: the task, arg: a trace_out_reason
+ * isr enter/exit - id: the exception number
+ * queue send/receive - id: the messages queued after, arg: the queue
+ * sem give/take - id: the count after, arg: the semaphore
+ * sem wait - id: 0, arg: the semaphore
+ * An object (a queue, a semaphore) is told by the low half of it's
+ * address - that's unique within the SRAM.
+ */
+typedef enum{
+    TRACE_TASK_IN = 1,
+    TRACE_TASK_OUT,
+    TRACE_ISR_ENTER,
+    TRACE_ISR_EXIT,
+    TRACE_QUEUE_SEND,
+    TRACE_QUEUE_RECEIVE,
+    TRACE_SEM_GIVE,
+    TRACE_SEM_TAKE,
+    TRACE_SEM_WAIT
+}trace_event;
+
+/* Why a task was switched out */
+typedef enum{
+    TRACE_OUT_DONE = 0,
+    TRACE_OUT_YIELDED,
+    TRACE_OUT_BLOCKED,
+    TRACE_OUT_PREEMPTED
+}trace_out_reason;
+
+/* A trace record - timestamped with the cycle counter. The 32-bit count
+ * wraps - the host side unwraps it, assuming no gap between records
+ * is as long as the wrap period.
+ */
+typedef struct{
+    uint32_t    cycles;
+    uint8_t     event;
+    uint8_t     id;
+    uint16_t    arg;
+}trace_entry;
+
+void trace_start(void);
+void trace_stop(void);
+void trace_record(uint8_t event, uint8_t id, uint16_t arg);
+void trace_dump(void);
+task_scheduler_err trace_service_start(uint8_t priority);
+bool trace_dump_request(void);
+
+/* A count as a record's id - saturated at 255 */
+static inline uint8_t trace_sat(uint32_t count)
+{
+    return (count > 0xFFu) ? 0xFFu : (uint8_t)count;
+}
+
+/* The low half of an object's address - how it's told in a record */
+static inline uint16_t trace_obj(const void* obj)
+{
+    return (uint16_t)(uintptr_t)obj;
+}
+
+#endif /* __TRACE_H__ */
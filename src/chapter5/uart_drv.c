@@ -3,6 +3,9 @@
 #include "lm3s6965_memmap.h"
 #include "uart_drv.h"
 #include "sysctl.h"
+#include "work_queue.h"
+#include "ring_buffer.h"
+#include "trace.h"
 
 /* UART register map structure.
  * Refer: http://www.ti.com/lit/ds/symlink/lm3s6965.pdf Table 12-3.
@@ -31,6 +34,15 @@ typedef struct __attribute__ ((packed)){
  */
 static volatile uart_regs *uart0 = (uart_regs*)UART0_BASE;
 
+/* Bytes received by the interrupt handler, waiting to be echoed.
+ * The handler is the only producer and the echo work the only consumer.
+ */
+RING_BUFFER_DEFINE(rx_ring, uint8_t, UART_RX_BUF_SIZE);
+
+static void uart_echo_work(void* arg);
+
+static work_item echo_work = WORK_ITEM_INIT(uart_echo_work, NULL);
+
 /* Enable the uart
  * TXE and RXE - transmit and recieve enable bits
  * are enabled out of reset - hence we don't set them here.
@@ -168,11 +180,56 @@ uart_err uart_rx_byte(uint8_t* byte)
     return UART_OK;
 }
 
+/* Echo the received bytes back - the bottom half of the interrupt handler,
+ * run from the work queue as uart_tx_byte() may well have to wait.
+ * Ctrl-T has the trace dumped instead (see trace_dump_request()).
+ */
+static void uart_echo_work(void* arg)
+{
+    uint8_t buf[UART_RX_BUF_SIZE];
+    uint32_t count, idx;
+    char c;
+
+    (void)arg;
+
+    while((count = ring_buffer_read(&rx_ring, buf, UART_RX_BUF_SIZE)) != 0)
+    {
+        for(idx = 0; idx < count; idx++)
+        {
+            c = buf[idx];
+
+            if(c == UART_TRACE_DUMP_KEY)
+            {
+                trace_dump_request();
+            }
+            else if(c == '\r')
+            {
+                uart_tx_byte('\n');
+            }
+            else if(c == '\b')
+            {
+                // TODO: Figure out how to handle backspace
+                // for now send X (which isn't working)
+                uart_tx_byte('X');
+            }
+            else
+            {
+                uart_tx_byte(c);
+            }
+        }
+    }
+}
+
+/* The top half - just buffer the byte and post the echo work.
+ * If the buffer is full, the byte is dropped.
+ */
 void uart0_irq_handler(void)
 {
     uint32_t irq_status;
     char c;
 
+    trace_record(TRACE_ISR_ENTER, UART0_EXCEPTION, 0);
+
     irq_status = uart_irq_status(true);
 
     uart_irq_clear(irq_status);
@@ -180,21 +237,11 @@ void uart0_irq_handler(void)
     if(irq_status & UART_RX_IRQ)
     {
         c = uart0->DR & UARTDR_DATA_MASK;
-        
-        if(c == '\r')
-        {
-            uart_tx_byte('\n');
-        }
-        else if(c == '\b')
-        {
-            // TODO: Figure out how to handle backspace
-            // for now send X (which isn't working)
-            uart_tx_byte('X');
-        }
-        else
-        {
-            uart_tx_byte(c);
-        }
+
+        ring_buffer_push(&rx_ring, &c);
+
+        work_queue_post(&echo_work);
     }
-}
 
+    trace_record(TRACE_ISR_EXIT, UART0_EXCEPTION, 0);
+}
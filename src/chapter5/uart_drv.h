@@ -35,6 +35,10 @@ typedef enum{
 #define UART_BAUD_57600     57600u
 #define UART_BAUD_115200    115200u
 
+#define UART_RX_BUF_SIZE    16u     // a power of two
+#define UART_TRACE_DUMP_KEY 0x14u   // Ctrl-T
+#define UART0_EXCEPTION     21u
+
 void uart_init(uint32_t baudrate);
 void uart_tx_byte(uint8_t byte);
 uart_err uart_rx_byte(uint8_t* byte);
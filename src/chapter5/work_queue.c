@@ -0,0 +1,72 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "context_switch.h"
+#include "work_queue.h"
+
+/* The posted work items - most recently posted first. Posting pushes
+ * onto this list with a single compare-and-swap (LDREX/STREX) and running
+ * the work takes the whole list with a single swap - so neither needs
+ * interrupts disabled, however the posting handlers nest.
+ */
+static work_item* volatile work_posted;
+
+/* Set up a work item to call fn(arg) when run */
+void work_init(work_item* work, work_fptr fn, void* arg) {
+    work->fn = fn;
+    work->arg = arg;
+    work->next = NULL;
+    work->queued = 0;
+}
+
+/* Queue a work item to run from PendSV - in O(1) and without a lock.
+ * Returns false if the item is already queued (it runs only the once).
+ */
+bool work_queue_post(work_item* work) {
+    uint8_t not_queued = 0;
+    work_item* head;
+
+    if(!__atomic_compare_exchange_n(&work->queued, &not_queued, 1u, false,
+                                    __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+        return false;
+    }
+
+    head = __atomic_load_n(&work_posted, __ATOMIC_RELAXED);
+    do {
+        work->next = head;
+    }while(!__atomic_compare_exchange_n(&work_posted, &head, work, true,
+                                        __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+
+    context_switch_pend();
+
+    return true;
+}
+
+/* Run all posted work items - in the order they were posted.
+ * Called from the PendSV handler.
+ */
+void work_queue_run(void) {
+    work_item* list;
+    work_item* fifo;
+
+    while((list = __atomic_exchange_n(&work_posted, NULL, __ATOMIC_ACQUIRE)) != NULL) {
+
+        // the list is newest first - reverse it
+        fifo = NULL;
+        while(list != NULL) {
+            work_item* next = list->next;
+            list->next = fifo;
+            fifo = list;
+            list = next;
+        }
+
+        while(fifo != NULL) {
+            work_item* work = fifo;
+            fifo = fifo->next;
+
+            // it may be posted again from here on - even while it runs
+            __atomic_store_n(&work->queued, 0u, __ATOMIC_RELEASE);
+            work->fn(work->arg);
+        }
+    }
+}
@@ -0,0 +1,31 @@
+#ifndef __WORK_QUEUE_H__
+#define __WORK_QUEUE_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Deferred work - the bottom half of an interrupt handler.
+ * An interrupt handler posts a work item and returns; the item's function
+ * runs later from the PendSV handler - at the lowest exception priority, so
+ * any other interrupt can preempt it. Work items are typically statically
+ * allocated, one per source of work.
+ */
+typedef void (*work_fptr)(void* arg);
+
+typedef struct work_item work_item;
+
+struct work_item{
+    work_fptr           fn;
+    void*               arg;
+    work_item*          next;
+    volatile uint8_t    queued;
+};
+
+#define WORK_ITEM_INIT(func, argument)  { (func), (argument), NULL, 0 }
+
+void work_init(work_item* work, work_fptr fn, void* arg);
+bool work_queue_post(work_item* work);
+void work_queue_run(void);
+
+#endif /* __WORK_QUEUE_H__ */